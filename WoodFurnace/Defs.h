@@ -8,7 +8,7 @@
 
 /////////////////////////////////////////////
 // Data version for saving and loading the EEPROM
-#define WOODSTOVE_DATA_VERSION	(1)
+#define WOODSTOVE_DATA_VERSION	(2)	// 2 - separate idle and run PID gains
 
 /////////////////////////////////////////////
 // Flue temps and limits.
@@ -32,6 +32,9 @@
 											// this far *below* target for flue_temp_wait_time then the
 											// fire must be dying. The "feed me" alarm may be triggered
 
+#define AMBIENT_REFERENCE_TEMP		(65)	// If there is an ambient sensor, flue temps used for control are
+											// corrected to what they would be at this ambient temperature
+
 /////////////////////////////////////////////
 // Forced draft controls
 #define MIN_FORCED_DRAFT_TEMP			(100)	// As flue temp. The FDB will not come on below this temperature
@@ -57,10 +60,64 @@
 #define PWM_MOTOR_MAX_COMMAND	(215)				// Largest PWM command (fan going as fast as possible)
 
 // Coefs for the flue temp PID
+#define FLUE_PID_SCALE	(0.10)	// Settings hold the gains times 10, see CWSPID::SetScale()
+#define FLUE_PID_TRACKING_TIME	(10L * ONE_SECOND_MS)	// Anti-windup time constant for the blower's dead zone
+#define FLUE_PID_D_FILTER_TIME	(8L * ONE_SECOND_MS)	// Low-pass on the D term, the flue reads in whole degrees
+
+// Feedforward, blower PWM counts added when we know the fire is about
+// to need more (or less) air, decaying as the flue catches up
+#define FLUE_FF_CALL_FOR_HEAT	(20)	// Thermostat starts calling for heat
+#define FLUE_FF_FAN_ON			(20)	// Circulation fan starts pulling heat out (less when it stops)
+#define FLUE_FF_DECAY_TIME		(60L * ONE_SECOND_MS)	// Twice the flue's transport delay
 #define DEF_KP	(0.0)
 #define DEF_KI	(0.0)
 #define DEF_KD	(0.0)
 
+// Going up, the setpoint is ramped instead of stepped so the blower
+// doesn't saturate and overshoot toward the alarm temp. Going down
+// it steps, the blower can't cool the stove anyway.
+#define SETPOINT_RAMP_RATE		(30)	// Degrees F per minute, 0 steps
+//#define SETPOINT_RAMP_S_CURVE			// Ease in and out of the ramp
+
+// Compile time choice of flue controller. With the Smith predictor the
+// PID works on a model's prediction of where the flue is headed, which
+// takes the transport delay out of the loop. It wants much hotter gains
+// than plain PID (Kp 10, Ki 0.5, Kd 0 on the simulator). It stays off
+// because those gains chatter the blower: on the simulated burn it
+// makes about 9x the PWM changes plain PID does, for 10-30% less error.
+//#define FLUE_CONTROL_SMITH_PREDICTOR
+
+// Plant model for the Smith predictor, matches CStoveSim
+#define FLUE_MODEL_GAIN				(2.12)	// Degrees F per PWM count, at steady state
+#define FLUE_MODEL_TIME_CONSTANT	(30L * ONE_SECOND_MS)
+#define FLUE_MODEL_DEAD_TIME		(30)	// Samples (seconds at 1 Hz)
+
+// Cascade control. The flue PID (the gains on the setup screen) sets a
+// firebox temperature, and a fast inner PID on the firebox probe drives
+// the blower, so a collapsed log or an open door is caught at the
+// firebox instead of 30 seconds later in the flue. Needs
+// PIN_THERMOCOUPLE_CS_FIREBOX. Flue gains of Kp 5.0, Ki 0.2, Kd 0 work
+// on the simulator. Relay autotune is not available in this mode.
+//#define FLUE_CONTROL_CASCADE
+
+#define FIREBOX_SETPOINT_MIN		(MIN_FORCED_DRAFT_TEMP)	// What the flue loop can ask of the firebox
+#define FIREBOX_SETPOINT_MAX		(1000)
+#define FIREBOX_SETPOINT_TRACKING_TIME	(10L * ONE_SECOND_MS)	// Flue loop anti-windup while the blower is pinned
+#define FIREBOX_PID_KP				(2.0)	// Inner loop, PWM counts per degree F (not scaled)
+#define FIREBOX_PID_KI				(0.05)
+#define FIREBOX_PID_KD				(0.0)
+#define FIREBOX_PID_OUTPUT_FILTER_TIME	(3L * ONE_SECOND_MS)	// Smooths the blower over the firebox's degree ticks
+
+// Learn the stove's dead time, time constant and gain while the PID
+// runs, and report them on the serial log. Costs about 550 bytes of RAM.
+//#define PLANT_ESTIMATOR
+
+// The stove behaves differently at the idle and run setpoints,
+// so each has its own set of PID gains
+#define PID_GAINS_IDLE		(0)
+#define PID_GAINS_RUN		(1)
+#define PID_GAINS_COUNT		(2)
+
 /////////////////////////////////////////////
 // Beeper on/off times for add-fuel and
 // alarm notifications
@@ -89,6 +146,61 @@
 #define SETUP_TIME_BUMP			(750L)	// how long to hold a +/- key to move by larger units
 #define HOLD_TIME_SYSTEM_RESET	(5000L)	// how long to hold the left key (normal screen) to reset to defaults
 
+/////////////////////////////////////////////
+// Task periods and phase offsets (in MS) for the scheduler in
+// loop(). The phases keep tasks that share a period from
+// coming due on the same pass. The sensor manager keeps its
+// own per-channel read schedule, this is only how often it
+// gets to look at it.
+#define SCHED_SENSOR_PERIOD		(250L)		// 4 Hz, the firebox probe's conversion time
+#define SCHED_SENSOR_PHASE		(0L)
+#define SCHED_PID_PERIOD		SCHED_SENSOR_PERIOD		// Runs right behind each sensor pass
+#define SCHED_PID_PHASE			(SCHED_SENSOR_PHASE + 5L)
+#define SCHED_BUTTON_PERIOD		(20L)
+#define SCHED_BUTTON_PHASE		(2L)
+#define SCHED_BEEPER_PERIOD		(100L)
+#define SCHED_BEEPER_PHASE		(17L)
+#define SCHED_DISPLAY_PERIOD	(500L)
+#define SCHED_DISPLAY_PHASE		(33L)
+#define SCHED_ONE_SECOND_PERIOD	(ONE_SECOND_MS)
+#define SCHED_ONE_SECOND_PHASE	(ONE_SECOND_MS + 241L)
+#define SCHED_PROFILER_PERIOD	(500L)		// Only with LOOP_PROFILER
+#define SCHED_PROFILER_PHASE	(71L)
+
+// Each task's run time budget in microseconds. A run that takes
+// longer is counted as an overrun in the TASK report. They are
+// estimates (two MAX6675 frames bit banged, the LCD shield's I2C
+// writes, the state machine's serial logging), LOOP_PROFILER
+// has the real numbers. The profiler's own task overruns when it
+// prints a report.
+#define SCHED_SENSOR_BUDGET		(2000L)
+#define SCHED_PID_BUDGET		(1000L)
+#define SCHED_BUTTON_BUDGET		(1000L)
+#define SCHED_BEEPER_BUDGET		(200L)
+#define SCHED_DISPLAY_BUDGET	(20000L)
+#define SCHED_ONE_SECOND_BUDGET	(20000L)
+#define SCHED_PROFILER_BUDGET	(1000L)
+
+// How many missed periods a task makes up after the loop stalls,
+// running once per pass until it is back on time. Only the one
+// second tick makes any up, the simulator and the state machine's
+// per-second work (the setpoint ramp, fire checks) count ticks.
+// A longer stall than this is skipped, and uptime still counts it.
+#define SCHED_CATCH_UP_NONE			(0)
+#define SCHED_ONE_SECOND_CATCH_UP	(10)
+
+// Idle the CPU when no task is due, waking on the millis() tick or a
+// change on the blast, mute, call for heat or call for fan inputs.
+// Takes over the PCINT1 and PCINT2 interrupt vectors. Off until
+// the wake latency and idle fraction have been measured on the
+// board, LOOP_PROFILER's "wake" and "sleep" lines.
+//#define IDLE_SLEEP
+
+// Time each task and subsystem with micros(), and print the counts,
+// mean, worst and a histogram when PROFILE_REPORT_CHAR is sent on the
+// serial port. Runs as its own task. Costs about 340 bytes of RAM.
+//#define LOOP_PROFILER
+
 /////////////////////////////////////////////
 // Dang relay board is backwards
 #define RELAY_ON	(0)
@@ -101,7 +213,6 @@
 
 /////////////////////////////////////////////
 // Debug Settings
-//#define DEBUG_INO
 //#define DEBUG_SETTINGS
 //#define DEBUG_FAN_CONTROLLER
 //#define DEBUG_TEMP_CONTROLLER
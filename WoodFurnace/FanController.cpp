@@ -6,11 +6,15 @@
 #include "Pins.h"
 #include "Defs.h"
 #include "Settings.h"
+#include "SensorFilter.h"
 #include "TempSensor_Thermocouple.h"
+#include "ThermocoupleBus.h"
+#include "TempSensor_Thermistor.h"
+#include "TempSensorManager.h"
 
 #include "FanController.h"
 
-extern CTempSensor_Thermocouple g_thermocouple;
+extern CTempSensorManager g_tempSensors;
 extern CWoodStoveSettings g_woodStoveSettings;
 
 ////////////////////////////////////////////////////////////
@@ -64,8 +68,11 @@ void CFanController::processOneSecond()
 	}
 
 	// ----------------------------------------
-	// Control the fan
-	int currentTemp = g_thermocouple.temperature();
+	// Control the fan. Use the plenum probe if there is one
+	// and it's working, otherwise the flue temp stands in for it.
+	int currentTemp = g_tempSensors.temperature(TEMP_SENSOR_PLENUM);
+	if(currentTemp == THERMOCOUPLE_INVALID_TEMP)
+		currentTemp = g_tempSensors.temperature(TEMP_SENSOR_FLUE);
 	if(currentTemp != THERMOCOUPLE_INVALID_TEMP)
 	{
 
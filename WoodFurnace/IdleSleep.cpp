@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////
+// Idle sleep between passes through loop()
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+#include <avr/sleep.h>
+
+#include "Pins.h"
+#include "Defs.h"
+
+#include "IdleSleep.h"
+
+#ifdef IDLE_SLEEP
+
+static volatile bool s_inputChanged = false;
+static volatile uint32_t s_changeMicros = 0;
+
+// The inputs are on ports C and D on an Uno. The other
+// pin-change vector is left alone for libraries that want it.
+static void inputChange()
+{
+	if(!s_inputChanged)
+	{
+		s_changeMicros = micros();
+		s_inputChanged = true;
+	}
+}
+
+ISR(PCINT1_vect)
+{
+	inputChange();
+}
+
+ISR(PCINT2_vect)
+{
+	inputChange();
+}
+
+static void enablePinChange(int _pin)
+{
+	volatile uint8_t *pcicr = digitalPinToPCICR(_pin);
+	volatile uint8_t *pcmsk = digitalPinToPCMSK(_pin);
+
+	// Not every pin has one
+	if(!pcicr || !pcmsk)
+		return;
+
+	*pcmsk |= _BV(digitalPinToPCMSKbit(_pin));
+	*pcicr |= _BV(digitalPinToPCICRbit(_pin));
+}
+
+// =================================================
+// 'structors
+// =================================================
+CIdleSleep::CIdleSleep()
+{
+}
+
+CIdleSleep::~CIdleSleep()
+{
+}
+
+// =================================================
+// Prepare for operation
+// =================================================
+void CIdleSleep::setup()
+{
+	// The pins are already inputs with pullups, set up
+	// by the controllers that read them
+	enablePinChange(PIN_FD_BLAST);
+	enablePinChange(PIN_MUTE_ALARM);
+	enablePinChange(PIN_CALL_FOR_HEAT);
+	enablePinChange(PIN_CALL_FOR_FAN);
+
+	set_sleep_mode(SLEEP_MODE_IDLE);
+}
+
+// =================================================
+// Operate
+// =================================================
+uint32_t CIdleSleep::sleep()
+{
+	uint32_t start = micros();
+
+	// The instruction after sei() always runs before any
+	// interrupt, so an input change can't slip in between
+	// the check and going to sleep
+	noInterrupts();
+	if(s_inputChanged)
+	{
+		interrupts();
+		return 0;
+	}
+	sleep_enable();
+	interrupts();
+	sleep_cpu();
+	sleep_disable();
+
+	return micros() - start;
+}
+
+bool CIdleSleep::inputChanged(uint32_t &_changeMicros)
+{
+	bool changed;
+
+	noInterrupts();
+	changed = s_inputChanged;
+	_changeMicros = s_changeMicros;
+	s_inputChanged = false;
+	interrupts();
+
+	return changed;
+}
+
+#endif
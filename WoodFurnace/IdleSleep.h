@@ -0,0 +1,35 @@
+////////////////////////////////////////////////////////////
+// Idle sleep between passes through loop()
+////////////////////////////////////////////////////////////
+#ifndef IdleSleep_h
+#define IdleSleep_h
+
+////////////////////////////////////////////////////////////
+// When no task is due the CPU idles instead of spinning.
+// Idle sleep keeps every clock and peripheral running, so
+// the millis() timer wakes it every 1.024 ms, as do serial,
+// I2C, and a pin-change interrupt on the front panel and
+// thermostat inputs. Nothing due can be late by more than
+// that millisecond, and a pin change flags the inputs so
+// loop() can check them at once instead of waiting for the
+// next poll.
+////////////////////////////////////////////////////////////
+class CIdleSleep
+{
+public:
+	CIdleSleep();
+	virtual ~CIdleSleep();
+
+	// Enable the pin-change interrupts
+	void setup();
+
+	// Sleep until the next interrupt, unless an input has
+	// already changed. Returns how long it slept, in us.
+	uint32_t sleep();
+
+	// True once per input change, with the micros() of the
+	// interrupt in _changeMicros
+	bool inputChanged(uint32_t &_changeMicros);
+};
+
+#endif
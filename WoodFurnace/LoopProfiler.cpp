@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////
+// Per-subsystem execution time profiler
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+
+#include "LoopProfiler.h"
+
+#ifdef LOOP_PROFILER
+
+static const char s_nameLoop[] PROGMEM = "loop";
+static const char s_nameSleep[] PROGMEM = "sleep";
+static const char s_nameWake[] PROGMEM = "wake";
+static const char s_nameSensors[] PROGMEM = "sensors";
+static const char s_namePID[] PROGMEM = "pid";
+static const char s_nameButtons[] PROGMEM = "buttons";
+static const char s_nameBeeper[] PROGMEM = "beeper";
+static const char s_nameDisplay[] PROGMEM = "display";
+static const char s_nameStoveSim[] PROGMEM = "stovesim";
+static const char s_nameSensorHealth[] PROGMEM = "sensorhealth";
+static const char s_nameFan[] PROGMEM = "fan";
+static const char s_nameStateMachine[] PROGMEM = "statemachine";
+
+static const char * const s_profileNames[profile_count] =
+{
+	s_nameLoop,
+	s_nameSleep,
+	s_nameWake,
+	s_nameSensors,
+	s_namePID,
+	s_nameButtons,
+	s_nameBeeper,
+	s_nameDisplay,
+	s_nameStoveSim,
+	s_nameSensorHealth,
+	s_nameFan,
+	s_nameStateMachine,
+};
+
+// =================================================
+// 'structors
+// =================================================
+CLoopProfiler::CLoopProfiler()
+{
+	reset();
+}
+
+CLoopProfiler::~CLoopProfiler()
+{
+}
+
+void CLoopProfiler::reset()
+{
+	for(int _ = 0; _ < profile_count; ++_)
+	{
+		CLoopProfile_slotT &slot = m_slots[_];
+
+		slot.m_count = 0;
+		slot.m_total = 0;
+		slot.m_min = 0xFFFFFFFFUL;
+		slot.m_max = 0;
+		for(int bin = 0; bin < PROFILE_BINS; ++bin)
+			slot.m_bins[bin] = 0;
+	}
+}
+
+// =================================================
+// Operate
+// =================================================
+void CLoopProfiler::record(CLoopProfile_idE _id, uint32_t _micros)
+{
+	CLoopProfile_slotT &slot = m_slots[_id];
+
+	// Keep the mean, lose the oldest history
+	if(slot.m_total & 0x80000000UL)
+	{
+		slot.m_total >>= 1;
+		slot.m_count >>= 1;
+	}
+	slot.m_count++;
+	slot.m_total += _micros;
+
+	if(_micros < slot.m_min)
+		slot.m_min = _micros;
+	if(_micros > slot.m_max)
+		slot.m_max = _micros;
+
+	int bin = 0;
+	for(uint32_t limit = (1UL << PROFILE_BIN0_SHIFT); (bin < (PROFILE_BINS - 1)) && (_micros >= limit); limit <<= 1)
+		++bin;
+
+	if(slot.m_bins[bin] == 0xFF)
+	{
+		for(int _ = 0; _ < PROFILE_BINS; ++_)
+			slot.m_bins[_] >>= 1;
+	}
+	slot.m_bins[bin]++;
+}
+
+void CLoopProfiler::processDebug()
+{
+	bool requested = false;
+
+	while(Serial.available() > 0)
+	{
+		if(Serial.read() == PROFILE_REPORT_CHAR)
+			requested = true;
+	}
+
+	if(requested)
+		printReport();
+}
+
+void CLoopProfiler::printReport()
+{
+	for(int _ = 0; _ < profile_count; ++_)
+		printSlot(_);
+}
+
+// PROF, uptime, name, count, min, mean, max, bins (8us, 16us, ... 8ms+)
+void CLoopProfiler::printSlot(int _id)
+{
+	CLoopProfile_slotT &slot = m_slots[_id];
+
+	if(slot.m_count == 0)
+		return;
+
+	Serial.print(F("PROF, "));
+	printUptime(false);
+	Serial.print(F(", "));
+	Serial.print((const __FlashStringHelper *)s_profileNames[_id]);
+	Serial.print(F(", "));
+	Serial.print(slot.m_count);
+	Serial.print(F(", "));
+	Serial.print(slot.m_min);
+	Serial.print(F(", "));
+	Serial.print(slot.m_total / slot.m_count);
+	Serial.print(F(", "));
+	Serial.print(slot.m_max);
+	for(int bin = 0; bin < PROFILE_BINS; ++bin)
+	{
+		if(bin == 0)
+			Serial.print(F(", "));
+		else
+			Serial.print(F(" "));
+		Serial.print(slot.m_bins[bin]);
+	}
+	Serial.println();
+}
+
+#endif
@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////
+// Per-subsystem execution time profiler
+////////////////////////////////////////////////////////////
+#ifndef LoopProfiler_h
+#define LoopProfiler_h
+
+#ifdef LOOP_PROFILER
+
+// What gets timed. Keep s_profileNames in LoopProfiler.cpp in step.
+typedef enum
+{
+	profile_loop = 0,		// A whole pass through loop() that ran a task
+	profile_sleep,			// Each idle sleep
+	profile_wake,			// Input change interrupt to the task that reads it
+	profile_sensors,
+	profile_pid,
+	profile_buttons,
+	profile_beeper,
+	profile_display,
+	profile_stoveSim,
+	profile_sensorHealth,
+	profile_fan,
+	profile_stateMachine,
+	profile_count
+} CLoopProfile_idE;
+
+// Histogram bin N counts runs of under 2^(N+3) us, the last
+// bin everything longer (8 ms and up)
+#define PROFILE_BINS			(12)
+#define PROFILE_BIN0_SHIFT		(3)
+#define PROFILE_REPORT_CHAR		('p')	// Send this on the serial port to get a report
+
+////////////////////////////////////////////////////////////
+// Keeps count, min, mean, max and a log2 histogram of the
+// micros() taken by each subsystem. Only adds and compares,
+// but the slots take about 340 bytes of RAM, so it is only
+// built with LOOP_PROFILER. Totals are halved along with the
+// count when they get big, and the histogram bins are bytes
+// that all get halved when one fills, so the mean and the
+// shape of the histogram survive running for months.
+////////////////////////////////////////////////////////////
+class CLoopProfiler
+{
+protected:
+	typedef struct
+	{
+		uint32_t m_count;
+		uint32_t m_total;
+		uint32_t m_min;
+		uint32_t m_max;
+		unsigned char m_bins[PROFILE_BINS];
+	} CLoopProfile_slotT;
+
+	CLoopProfile_slotT m_slots[profile_count];
+
+	void printSlot(int _id);
+
+public:
+	CLoopProfiler();
+	virtual ~CLoopProfiler();
+
+	void reset();
+
+	void record(CLoopProfile_idE _id, uint32_t _micros);
+
+	// Its own scheduled task, prints a report when one has
+	// been asked for on the serial port
+	void processDebug();
+	void printReport();
+};
+
+////////////////////////////////////////////////////////////
+// Times the enclosing block
+class CProfileScope
+{
+protected:
+	CLoopProfiler &m_profiler;
+	CLoopProfile_idE m_id;
+	uint32_t m_start;
+
+public:
+	CProfileScope(CLoopProfiler &_profiler, CLoopProfile_idE _id)
+		: m_profiler(_profiler), m_id(_id)
+	{
+		m_start = micros();
+	}
+
+	~CProfileScope()
+	{
+		m_profiler.record(m_id, micros() - m_start);
+	}
+};
+
+extern CLoopProfiler g_loopProfiler;
+
+// So the timed code doesn't need its own #ifdefs
+#define PROFILE_SCOPE(_id)				CProfileScope profile(g_loopProfiler, _id)
+#define PROFILE_RECORD(_id, _micros)	g_loopProfiler.record(_id, _micros)
+
+#else
+
+// _micros is still evaluated
+#define PROFILE_SCOPE(_id)
+#define PROFILE_RECORD(_id, _micros)	UNUSED(_micros)
+
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////
+// A simple class to help with arduino based millisecond timers
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+#include "MilliTimer.h"
+
+extern CTimerWheel g_timerWheel;
+
+// =================================================
+// CTimerWheel
+// =================================================
+CTimerWheel::CTimerWheel()
+{
+	for(int _ = 0; _ < TIMER_WHEEL_SLOTS; ++_)
+		m_slots[_] = 0;
+	m_expiring = 0;
+
+	m_current = 0;
+	m_lastTick = 0;
+}
+
+CTimerWheel::~CTimerWheel()
+{
+}
+
+void CTimerWheel::start(uint32_t _now)
+{
+	m_lastTick = _now;
+}
+
+void CTimerWheel::advance(uint32_t _now)
+{
+	// Tick on the grid, so the wheel doesn't drift
+	// behind the clock when a pass runs long
+	while((_now - m_lastTick) >= TIMER_WHEEL_TICK_MS)
+	{
+		m_lastTick += TIMER_WHEEL_TICK_MS;
+		m_current = (m_current + 1) & (TIMER_WHEEL_SLOTS - 1);
+
+		// Move everything that is due off the slot first. A callback
+		// that starts a timer a multiple of TIMER_WHEEL_SLOTS ticks out
+		// puts it back in this slot, and it mustn't be seen again
+		// until the wheel comes round.
+		CMilliTimer **link = &m_slots[m_current];
+		CMilliTimer **tail = &m_expiring;
+		while(*link)
+		{
+			CMilliTimer *timer = *link;
+
+			if(timer->m_rounds > 0)
+			{
+				timer->m_rounds--;
+				link = &timer->m_next;
+				continue;
+			}
+
+			*link = timer->m_next;
+			timer->m_next = 0;
+			*tail = timer;
+			tail = &timer->m_next;
+		}
+
+		// Still running until they come off m_expiring, so a callback
+		// that resets or starts one further down takes it off with remove()
+		while(m_expiring)
+		{
+			CMilliTimer *timer = m_expiring;
+
+			m_expiring = timer->m_next;
+			timer->m_next = 0;
+			timer->m_state = CMilliTimer::expired;
+
+			if(timer->m_callback)
+				timer->m_callback(timer->m_context);
+		}
+	}
+}
+
+void CTimerWheel::add(CMilliTimer *_timer, uint32_t _ticks)
+{
+	unsigned char slot = (m_current + _ticks) & (TIMER_WHEEL_SLOTS - 1);
+
+	_timer->m_rounds = (_ticks - 1) / TIMER_WHEEL_SLOTS;
+	_timer->m_next = m_slots[slot];
+	m_slots[slot] = _timer;
+}
+
+void CTimerWheel::remove(CMilliTimer *_timer)
+{
+	// Slot TIMER_WHEEL_SLOTS is the expiring list
+	for(int _ = 0; _ <= TIMER_WHEEL_SLOTS; ++_)
+	{
+		CMilliTimer **head = (_ < TIMER_WHEEL_SLOTS) ? &m_slots[_] : &m_expiring;
+		for(CMilliTimer **link = head; *link; link = &(*link)->m_next)
+		{
+			if(*link == _timer)
+			{
+				*link = _timer->m_next;
+				_timer->m_next = 0;
+				return;
+			}
+		}
+	}
+}
+
+// =================================================
+// CMilliTimer
+// =================================================
+void CMilliTimer::start(uint32_t _time, CMilliTimer_callbackT _callback, void *_context)
+{
+	if(m_state == running)
+		g_timerWheel.remove(this);
+
+	m_callback = _callback;
+	m_context = _context;
+	m_state = running;
+
+	// Rounded up, plus the part of the current tick that
+	// has already gone by, so it can never expire early
+	g_timerWheel.add(this, ((_time + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS) + 1);
+}
+
+void CMilliTimer::reset()
+{
+	if(m_state == running)
+		g_timerWheel.remove(this);
+
+	m_state = notSet;
+}
@@ -4,9 +4,50 @@
 #ifndef MilliTimer_h
 #define MilliTimer_h
 
+#define TIMER_WHEEL_TICK_MS		(10)	// Resolution of every CMilliTimer
+#define TIMER_WHEEL_SLOTS		(16)	// Power of two
+
+class CMilliTimer;
+
+// Called from CTimerWheel::advance() when a timer expires
+typedef void (*CMilliTimer_callbackT)(void *_context);
+
+////////////////////////////////////////////////////////////
+// All the running CMilliTimers hang off this. Each timer sits
+// in the slot its expiry tick hashes to, with the number of
+// whole turns of the wheel still to go. advance() is called
+// once per pass through loop() with that pass's millis(), and
+// only looks at the slots for the ticks that went by, so the
+// timers are all expired against the same "now" and nobody
+// else has to read the clock to find out.
+//
+// The callbacks only run once a tick's slot has been walked,
+// off a list of their own, so they can start or reset any
+// timer (their own included) without upsetting the walk.
+////////////////////////////////////////////////////////////
+class CTimerWheel
+{
+protected:
+	CMilliTimer *m_slots[TIMER_WHEEL_SLOTS];
+	CMilliTimer *m_expiring;		// Off the wheel, callbacks still to run
+	unsigned char m_current;
+	uint32_t m_lastTick;		// millis() of the last tick processed
+
+public:
+	CTimerWheel();
+	virtual ~CTimerWheel();
+
+	void start(uint32_t _now);
+	void advance(uint32_t _now);
+
+	void add(CMilliTimer *_timer, uint32_t _ticks);
+	void remove(CMilliTimer *_timer);
+};
 
 class CMilliTimer
 {
+	friend class CTimerWheel;
+
 public:
 	typedef enum
 	{
@@ -16,44 +57,42 @@ public:
 	} CMilliTimerStateE;
 
 protected:
-	unsigned long m_interval;
-	unsigned long m_startingMillis;
-
 	CMilliTimerStateE m_state;
 
+	// Owned by the wheel while running
+	CMilliTimer *m_next;
+	uint32_t m_rounds;
+
+	CMilliTimer_callbackT m_callback;
+	void *m_context;
+
 public:
 	CMilliTimer()
 	{
-		reset();
+		m_next = 0;
+		m_rounds = 0;
+		m_callback = 0;
+		m_context = 0;
+		m_state = notSet;
 	}
 
-	virtual ~CMilliTimer() {}
-
-	void start(unsigned long _time)
+	virtual ~CMilliTimer()
 	{
-		m_startingMillis = millis();
-		m_interval = _time;
-
-		m_state = running;
+		reset();
 	}
 
+	// Expires once more than _time ms have gone by, rounded
+	// up to the wheel's tick. The callback, if any, is run
+	// by the wheel as it expires.
+	void start(uint32_t _time, CMilliTimer_callbackT _callback = 0, void *_context = 0);
+
+	// No clock read, this is as of the last CTimerWheel::advance()
 	CMilliTimerStateE getState()
 	{
-		if((m_state == running) && ((millis() - m_startingMillis) > m_interval))
-		{
-			m_state = expired;
-		}
-
 		return m_state;
 	}
 
-	void reset()
-	{
-		m_interval = 0;
-		m_startingMillis = 0L;
-
-		m_state = notSet;
-	}
+	void reset();
 };
 
 #endif
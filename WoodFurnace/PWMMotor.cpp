@@ -74,7 +74,7 @@ void CPWMMotor::setSpeed(int _speed)
 #endif
 		m_lastCommand = _speed;
 		writePWM(PWM_MOTOR_MAX_COMMAND);
-		m_startupTimer.start(PWM_MOTOR_STARTUP_TIME);
+		m_startupTimer.start(PWM_MOTOR_STARTUP_TIME, startupComplete, this);
 	}
 	else
 	{
@@ -88,29 +88,25 @@ void CPWMMotor::setSpeed(int _speed)
 		// change the motor speed while the startup timer is still running,
 		// we don't want to write the PWM value yet because the motor
 		// may fail to start. So, we only set the
-		// PWM value if the timer is not set. If the timer is either
-		// running or expired then the PWM value will be written
-		// later, in the processFast() method below.
+		// PWM value if the timer is not set. If the timer is running
+		// then the PWM value will be written when it expires, in
+		// startupComplete() below.
 		if(m_startupTimer.getState() == CMilliTimer::notSet)
 			writePWM(m_lastCommand);
 	}
 }
 
-void CPWMMotor::processFast()
+// The startup timer's callback. Resetting the timer changes its state
+// back to CMilliTimer::notSet, so this only happens once per motor start.
+void CPWMMotor::startupComplete(void *_context)
 {
-	// If the timer is in expired state the it had to have been started.
-	// That only happens when we are starting the motor, so when it expires
-	// just write the correct speed. Resetting the timer changes its state
-	// to CMilliTimer::state_notSet, so this will only happen once per
-	// motor start.
-	if(m_startupTimer.getState() == CMilliTimer::expired)
-	{
+	CPWMMotor *motor = (CPWMMotor *)_context;
+
 #ifdef DEBUG_PWM_MOTOR
-		Serial.println(F("CPWMMotor::setSpeed() - startup complete, setting speed."));
+	Serial.println(F("CPWMMotor::startupComplete() - startup complete, setting speed."));
 #endif
-		writePWM(m_lastCommand);
-		m_startupTimer.reset();
-	}
+	motor->writePWM(motor->m_lastCommand);
+	motor->m_startupTimer.reset();
 }
 
 void CPWMMotor::writePWM(int _speed)
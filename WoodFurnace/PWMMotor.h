@@ -17,6 +17,8 @@ protected:
 	CMilliTimer m_startupTimer;
 	void writePWM(int _speed);
 
+	static void startupComplete(void *_context);
+
 public:
 	CPWMMotor();
 	virtual ~CPWMMotor();
@@ -28,7 +30,13 @@ public:
 	{
 		return m_lastCommand;
 	}
-	void processFast();
+
+	// True while the motor is being kicked at full speed to get it
+	// turning, the commanded speed isn't what it is getting yet
+	bool isStarting()
+	{
+		return m_startupTimer.getState() != CMilliTimer::notSet;
+	}
 };
 
 #endif
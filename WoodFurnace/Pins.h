@@ -16,13 +16,33 @@
 #define PIN_FORCED_DRAFT_PWM	(9)
 
 
-// Thermocouple board IO
+// Thermocouple board IO. All of the MAX6675 boards share
+// SO, SCK and power, each one gets its own CS line.
 #define PIN_THERMOCOUPLE_SO		(10)
-#define PIN_THERMOCOUPLE_CS		(11)
 #define PIN_THERMOCOUPLE_SCK	(12)
 #define PIN_THERMOCOUPLE_VCC	(13)
 //#define PIN_THERMOCOUPLE_GND	(XX)
 
+// How the bus is clocked (pick one):
+//	THERMOCOUPLE_BUS_BITBANG	digitalWrite()/digitalRead(), works on any pins
+//	THERMOCOUPLE_BUS_DIRECT		direct port register access, works on any pins
+//	THERMOCOUPLE_BUS_HW_SPI		the SPI peripheral. SO and SCK must be rewired to
+//								the board's MISO and SCK pins (12 and 13 on an
+//								Uno), and VCC moved off of pin 13.
+// Bit banging is what the board has always run. The other two haven't
+// been timed on a board yet, DEBUG_TEMPSENSOR prints how long each
+// frame read takes in us for when they are.
+#define THERMOCOUPLE_BUS_BITBANG
+
+#define PIN_THERMOCOUPLE_CS_FLUE		(11)
+//#define PIN_THERMOCOUPLE_CS_FIREBOX	(6)		// Optional, define if the probe is installed
+//#define PIN_THERMOCOUPLE_CS_PLENUM	(7)		// Optional, define if the probe is installed
+
+
+// Ambient thermistor. Optional, define if installed. The Uno has
+// no spare analog pins (A4 / A5 are the LCD's I2C), so this needs
+// a board with A6 or above.
+//#define PIN_AMBIENT_THERMISTOR	(A6)
 
 // Circulation fan relay (big fan)
 #define PIN_FAN_RELAY			(A0)
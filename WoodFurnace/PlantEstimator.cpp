@@ -0,0 +1,203 @@
+////////////////////////////////////////////////////////////
+// Online estimate of the stove's dead time, time constant
+// and gain
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+#include <math.h>
+
+#include "Defs.h"
+#include "WSPID.h"
+
+#include "PlantEstimator.h"
+
+CPlantEstimator::CPlantEstimator()
+{
+	reset();
+}
+
+CPlantEstimator::~CPlantEstimator()
+{
+}
+
+void CPlantEstimator::reset()
+{
+	for(int _ = 0; _ < PLANT_EST_DELAY_COUNT; ++_)
+	{
+		CPlantEstimator_fitT &fit = m_fits[_];
+
+		for(int i = 0; i < PLANT_EST_PARAMS; ++i)
+			fit.m_theta[i] = 0.;
+
+		// Diagonal
+		for(int i = 0, n = 0; i < PLANT_EST_PARAMS; ++i)
+			for(int j = i; j < PLANT_EST_PARAMS; ++j, ++n)
+				fit.m_p[n] = (i == j) ? PLANT_EST_P_INIT : 0.;
+
+		fit.m_error = 0.;
+	}
+
+	m_seconds = 0;
+	restart();
+}
+
+void CPlantEstimator::restart()
+{
+	m_head = 0;
+	m_count = 0;
+	m_lastTemp = 0.;
+}
+
+// Index into the upper triangle of a symmetric matrix
+static int pIndex(int _i, int _j)
+{
+	if(_i > _j)
+	{
+		int t = _i;
+		_i = _j;
+		_j = t;
+	}
+
+	return (_i * (2 * PLANT_EST_PARAMS - _i - 1)) / 2 + _j;
+}
+
+void CPlantEstimator::processOneSecond(int32_t _temp, int _output)
+{
+#ifdef SERIAL_LOG
+	if(++m_seconds >= PLANT_EST_REPORT_INTERVAL)
+	{
+		m_seconds = 0;
+		printEstimate();
+	}
+#endif
+
+	float temp = (float)_temp / WSPID_FIXED_ONE;
+
+	// The newest command goes at m_head, so the one from n
+	// seconds ago is n entries behind it
+	m_outputs[m_head] = (unsigned char)constrain(_output, 0, 255);
+
+	// Need the whole history before every fit has its regressor,
+	// and the blower has to have moved within it. A steady stove
+	// fits every dead time equally well, so it can't tell us which
+	// one is right.
+	if((m_count >= PLANT_EST_HISTORY) && excited())
+	{
+		for(int _ = 0; _ < PLANT_EST_DELAY_COUNT; ++_)
+		{
+			int d = (_ + 1) * PLANT_EST_DELAY_STEP;
+			float x[PLANT_EST_PARAMS];
+
+			x[0] = m_lastTemp;
+			x[1] = m_outputs[(m_head + PLANT_EST_HISTORY - d) % PLANT_EST_HISTORY];
+			x[2] = 1.;
+
+			update(m_fits[_], x, temp);
+		}
+	}
+	else if(m_count < PLANT_EST_HISTORY)
+	{
+		m_count++;
+	}
+
+	m_lastTemp = temp;
+	m_head = (m_head + 1) % PLANT_EST_HISTORY;
+}
+
+bool CPlantEstimator::excited()
+{
+	unsigned char lo = 255;
+	unsigned char hi = 0;
+
+	for(int _ = 0; _ < PLANT_EST_HISTORY; ++_)
+	{
+		lo = min(lo, m_outputs[_]);
+		hi = max(hi, m_outputs[_]);
+	}
+
+	return (hi - lo) >= PLANT_EST_MIN_EXCITATION;
+}
+
+void CPlantEstimator::update(CPlantEstimator_fitT &_fit, const float *_x, float _y)
+{
+	float error = _y;
+	for(int i = 0; i < PLANT_EST_PARAMS; ++i)
+		error -= _fit.m_theta[i] * _x[i];
+
+	_fit.m_error = PLANT_EST_ERROR_FORGET * _fit.m_error + (1. - PLANT_EST_ERROR_FORGET) * error * error;
+
+	// Gain vector, k = P * x / (lambda + x' * P * x)
+	float px[PLANT_EST_PARAMS];
+	float denom = PLANT_EST_FORGET;
+	for(int i = 0; i < PLANT_EST_PARAMS; ++i)
+	{
+		px[i] = 0.;
+		for(int j = 0; j < PLANT_EST_PARAMS; ++j)
+			px[i] += _fit.m_p[pIndex(i, j)] * _x[j];
+		denom += _x[i] * px[i];
+	}
+
+	for(int i = 0; i < PLANT_EST_PARAMS; ++i)
+		_fit.m_theta[i] += px[i] / denom * error;
+
+	// P = (P - k * x' * P) / lambda, held below PLANT_EST_P_MAX so it
+	// doesn't blow up while the stove sits steady
+	for(int i = 0, n = 0; i < PLANT_EST_PARAMS; ++i)
+	{
+		for(int j = i; j < PLANT_EST_PARAMS; ++j, ++n)
+		{
+			_fit.m_p[n] = (_fit.m_p[n] - px[i] * px[j] / denom) / PLANT_EST_FORGET;
+			if((i == j) && (_fit.m_p[n] > PLANT_EST_P_MAX))
+				_fit.m_p[n] = PLANT_EST_P_MAX;
+		}
+	}
+}
+
+int CPlantEstimator::bestFit()
+{
+	int best = -1;
+
+	for(int _ = 0; _ < PLANT_EST_DELAY_COUNT; ++_)
+	{
+		const CPlantEstimator_fitT &fit = m_fits[_];
+
+		// Only stable, positive gain fits that have seen some data
+		if((fit.m_error <= 0.) || (fit.m_theta[0] <= 0.) || (fit.m_theta[0] >= 1.) || (fit.m_theta[1] <= 0.))
+			continue;
+
+		if((best < 0) || (fit.m_error < m_fits[best].m_error))
+			best = _;
+	}
+
+	return best;
+}
+
+int CPlantEstimator::getDeadTime()
+{
+	int best = bestFit();
+	return (best < 0) ? 0 : (best + 1) * PLANT_EST_DELAY_STEP;
+}
+
+float CPlantEstimator::getTimeConstant()
+{
+	int best = bestFit();
+	return (best < 0) ? 0. : -1. / log(m_fits[best].m_theta[0]);
+}
+
+float CPlantEstimator::getGain()
+{
+	int best = bestFit();
+	return (best < 0) ? 0. : m_fits[best].m_theta[1] / (1. - m_fits[best].m_theta[0]);
+}
+
+void CPlantEstimator::printEstimate()
+{
+	// PLANT, uptime, dead time, time constant, gain
+	Serial.print(F("PLANT, "));
+	printUptime(false);
+	Serial.print(F(", "));
+	Serial.print(getDeadTime());
+	Serial.print(F(", "));
+	Serial.print(getTimeConstant(), 1);
+	Serial.print(F(", "));
+	Serial.println(getGain(), 3);
+}
@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////
+// Online estimate of the stove's dead time, time constant
+// and gain
+////////////////////////////////////////////////////////////
+#ifndef PlantEstimator_h
+#define PlantEstimator_h
+
+#define PLANT_EST_DELAY_STEP		(5)		// Seconds between the dead times tried
+#define PLANT_EST_DELAY_COUNT		(12)	// Dead times tried, 5 to 60 seconds
+#define PLANT_EST_HISTORY			(PLANT_EST_DELAY_STEP * PLANT_EST_DELAY_COUNT + 2)
+#define PLANT_EST_MIN_EXCITATION	(5)		// PWM counts the blower has to move to learn anything
+#define PLANT_EST_PARAMS			(3)
+#define PLANT_EST_P_SIZE			(PLANT_EST_PARAMS * (PLANT_EST_PARAMS + 1) / 2)
+#define PLANT_EST_FORGET			(0.998)	// RLS forgetting factor, ~8 minute memory
+#define PLANT_EST_ERROR_FORGET		(0.99)	// Prediction error average, ~2 minutes
+#define PLANT_EST_P_INIT			(1000.)	// Starting covariance, we know nothing
+#define PLANT_EST_P_MAX				(1.0e4)	// Covariance is held below this when the stove is quiet
+#define PLANT_EST_REPORT_INTERVAL	(60L)	// Seconds between reports on the serial log
+
+////////////////////////////////////////////////////////////
+// Recursive least squares fit of a first order plus dead time
+// model, the same one the Smith predictor uses:
+//
+//   y[k] = a * y[k-1] + b * u[k-1-d] + c
+//
+// c soaks up the ambient temperature and the idle burn. Since
+// RLS can't fit d, a separate fit
+// runs for each of a handful of dead times, and whichever has
+// been predicting best is the answer. From a and b:
+//
+//   time constant = -dt / ln(a), gain = b / (1 - a)
+//
+// The blower commands are kept in a ring (a byte each). It
+// runs once a second, while the PID is driving the blower.
+////////////////////////////////////////////////////////////
+class CPlantEstimator
+{
+protected:
+	// One fit per candidate dead time
+	typedef struct
+	{
+		float m_theta[PLANT_EST_PARAMS];	// a, b, c
+		float m_p[PLANT_EST_P_SIZE];		// Covariance, upper triangle
+		float m_error;						// Averaged squared prediction error
+	} CPlantEstimator_fitT;
+
+	CPlantEstimator_fitT m_fits[PLANT_EST_DELAY_COUNT];
+
+	unsigned char m_outputs[PLANT_EST_HISTORY];
+	int m_head;
+	int m_count;	// Samples in the ring since the last restart
+
+	float m_lastTemp;
+
+	uint32_t m_seconds;
+
+	int bestFit();
+	bool excited();
+	void update(CPlantEstimator_fitT &_fit, const float *_x, float _y);
+
+public:
+	CPlantEstimator();
+	virtual ~CPlantEstimator();
+
+	// Forget everything
+	void reset();
+
+	// The data stops being continuous (the PID let go of the
+	// blower), keep the estimates but start the history over
+	void restart();
+
+	// Call once a second with the flue (Q8) and the blower
+	// command that was applied over the last second
+	void processOneSecond(int32_t _temp, int _output);
+
+	// Estimates, 0 until there is a believable fit
+	int getDeadTime();			// Seconds
+	float getTimeConstant();	// Seconds
+	float getGain();			// Degrees F per PWM count
+
+	void printEstimate();
+};
+
+#endif
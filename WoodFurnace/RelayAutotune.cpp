@@ -0,0 +1,154 @@
+////////////////////////////////////////////////////////////
+// Relay feedback PID autotuner
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+#include <math.h>
+
+#include "Defs.h"
+
+#include "RelayAutotune.h"
+
+CRelayAutotune::CRelayAutotune()
+{
+	m_state = state_off;
+	m_setpoint = 0;
+	m_relayHigh = false;
+	m_output = PWM_MOTOR_STOP;
+	m_bias = m_lowOutput = m_highOutput = PWM_MOTOR_STOP;
+	m_seconds = 0;
+	m_lastRiseTime = 0;
+	m_cycleMax = m_cycleMin = 0;
+	m_cycles = 0;
+	m_sumAmplitude = 0;
+	m_sumPeriod = 0;
+	m_Ku = m_Pu = 0.;
+}
+
+CRelayAutotune::~CRelayAutotune()
+{
+}
+
+void CRelayAutotune::start(int _setpoint, int _bias)
+{
+#ifdef DEBUG_TEMP_CONTROLLER
+	printUptime();
+	Serial.print(F("CRelayAutotune::start() - setpoint: "));
+	Serial.print(_setpoint);
+	Serial.print(F(" bias: "));
+	Serial.println(_bias);
+#endif
+
+	m_state = state_running;
+	m_setpoint = _setpoint;
+
+	// Either side of the bias, as far as the blower goes. The
+	// low side can't land in the motor's dead zone.
+	m_bias = constrain(_bias, PWM_MOTOR_STOP, PWM_MOTOR_MAX_COMMAND);
+	m_lowOutput = max(m_bias - AUTOTUNE_RELAY_STEP, PWM_MOTOR_STOP);
+	if(m_lowOutput < PWM_MOTOR_MIN_COMMAND)
+		m_lowOutput = PWM_MOTOR_STOP;
+	m_highOutput = min(m_bias + AUTOTUNE_RELAY_STEP, PWM_MOTOR_MAX_COMMAND);
+
+	// Start by heating
+	m_relayHigh = true;
+	m_output = m_highOutput;
+
+	m_seconds = 0;
+	m_lastRiseTime = 0;
+	m_cycleMax = -32767;
+	m_cycleMin = 32767;
+
+	// -1 so the first (unsettled) cycle is thrown away
+	m_cycles = -1;
+	m_sumAmplitude = 0;
+	m_sumPeriod = 0;
+
+	m_Ku = m_Pu = 0.;
+}
+
+void CRelayAutotune::cancel()
+{
+	m_state = state_off;
+	m_output = m_bias;
+}
+
+int CRelayAutotune::processOneSecond(int _temp)
+{
+	if(m_state != state_running)
+		return m_output;
+
+	m_seconds++;
+	if(m_seconds > AUTOTUNE_MAX_TIME)
+	{
+#ifdef DEBUG_TEMP_CONTROLLER
+		printUptime();
+		Serial.println(F("CRelayAutotune::processOneSecond() - timed out"));
+#endif
+		m_state = state_failed;
+		m_output = m_bias;
+		return m_output;
+	}
+
+	// Track the peaks of the current cycle
+	if(_temp > m_cycleMax)
+		m_cycleMax = _temp;
+	if(_temp < m_cycleMin)
+		m_cycleMin = _temp;
+
+	// Flip the relay when we cross the setpoint (with hysteresis)
+	if(m_relayHigh && (_temp > (m_setpoint + AUTOTUNE_HYSTERESIS)))
+	{
+		m_relayHigh = false;
+		m_output = m_lowOutput;
+	}
+	else if(!m_relayHigh && (_temp < (m_setpoint - AUTOTUNE_HYSTERESIS)))
+	{
+		// Each low -> high switch ends one full cycle
+		m_relayHigh = true;
+		m_output = m_highOutput;
+
+		if(m_cycles >= 0)
+		{
+			m_sumAmplitude += m_cycleMax - m_cycleMin;
+			m_sumPeriod += m_seconds - m_lastRiseTime;
+		}
+
+		m_cycles++;
+		m_lastRiseTime = m_seconds;
+		m_cycleMax = -32767;
+		m_cycleMin = 32767;
+
+		if(m_cycles >= AUTOTUNE_CYCLES)
+			finish();
+	}
+
+	return m_output;
+}
+
+void CRelayAutotune::finish()
+{
+	// Peak to peak -> amplitude
+	double a = (double)m_sumAmplitude / (2. * m_cycles);
+	double d = (m_highOutput - m_lowOutput) / 2.;
+
+	// Back to what was holding the setpoint
+	m_output = m_bias;
+
+	if(a <= 0.)
+	{
+		m_state = state_failed;
+		return;
+	}
+
+	m_Ku = (4. * d) / (M_PI * a);
+	m_Pu = (double)m_sumPeriod / m_cycles;
+	m_state = state_done;
+
+#ifdef DEBUG_TEMP_CONTROLLER
+	printUptime();
+	Serial.print(F("CRelayAutotune::finish() - Ku: "));
+	Serial.print(m_Ku);
+	Serial.print(F(" Pu: "));
+	Serial.println(m_Pu);
+#endif
+}
@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////
+// Relay feedback PID autotuner
+////////////////////////////////////////////////////////////
+#ifndef RelayAutotune_h
+#define RelayAutotune_h
+
+#define AUTOTUNE_RELAY_STEP		(60)				// Blower counts either side of where the PID was
+#define AUTOTUNE_HYSTERESIS		(3)					// Degrees F, keeps noise from chattering the relay
+#define AUTOTUNE_CYCLES			(4)					// Oscillations averaged (after the first settles)
+#define AUTOTUNE_MAX_TIME		(2L * 60L * 60L)	// Seconds, give up after this
+
+////////////////////////////////////////////////////////////
+// Astrom-Hagglund relay method. The blower is switched
+// between two levels whenever the flue crosses the setpoint,
+// which makes the stove oscillate at its ultimate period. From
+// the amplitude of that oscillation we get the ultimate gain,
+// and Ziegler-Nichols turns the two into gains.
+//
+// The levels are centered on what the blower was doing to hold
+// the setpoint, so the flue rises and falls at the same rate and
+// the period isn't stretched by the slow half. The stove is mostly
+// dead time and the flue is read in whole degrees, which classic
+// Z-N's derivative only turns into blower chatter, so the gains
+// are Z-N's PI.
+////////////////////////////////////////////////////////////
+class CRelayAutotune
+{
+public:
+	typedef enum
+	{
+		state_off = 0,
+		state_running,
+		state_done,
+		state_failed,
+	} CRelayAutotune_stateE;
+
+protected:
+	CRelayAutotune_stateE m_state;
+
+	int m_setpoint;
+	bool m_relayHigh;
+	int m_output;
+	int m_bias;			// Blower command that was holding the setpoint
+	int m_lowOutput;	// Blower command while the flue is above it...
+	int m_highOutput;	// ...and while it is below
+
+	uint32_t m_seconds;
+	uint32_t m_lastRiseTime;
+
+	int m_cycleMax;
+	int m_cycleMin;
+
+	int m_cycles;
+	int32_t m_sumAmplitude;
+	uint32_t m_sumPeriod;
+
+	// Results (unscaled, PWM counts per degree F)
+	double m_Ku;
+	double m_Pu;
+
+	void finish();
+
+public:
+	CRelayAutotune();
+	virtual ~CRelayAutotune();
+
+	// _bias is the blower command that was holding the setpoint
+	void start(int _setpoint, int _bias);
+	void cancel();
+
+	// Call once per second with the flue temp, returns the blower command
+	int processOneSecond(int _temp);
+	int getOutput() { return m_output; }
+
+	CRelayAutotune_stateE getState() { return m_state; }
+
+	// Ultimate gain / period, and Z-N PI gains from them
+	double getKu() { return m_Ku; }
+	double getPu() { return m_Pu; }
+	double getKp() { return 0.45 * m_Ku; }
+	double getKi() { return (m_Pu > 0.) ? (0.54 * m_Ku / m_Pu) : 0.; }
+	double getKd() { return 0.; }
+};
+
+#endif
@@ -109,17 +109,17 @@ void CScreenController::processFast()
 		screen->buttonCheck(m_buttonController);
 }
 
-void CScreenController::processOneSecond()
+void CScreenController::processDisplay()
 {
 	CScreen_Base *screen = findScreen(m_screenID);
 	if(screen)
 	{
 #ifdef DEBUG_SCREEN_CONTROLLER
 		printUptime();
-		Serial.print(F("CScreenController::processOneSecond: "));
+		Serial.print(F("CScreenController::processDisplay: "));
 		Serial.println(screen->getID());
 #endif
-		screen->processOneSecond();
+		screen->processDisplay();
 	}
 }
 
@@ -206,7 +206,7 @@ void CButtonController::setup()
 
 void CButtonController::processFast()
 {
-	unsigned long curMillies = millis();
+	uint32_t curMillies = millis();
 
 	// Read the raw button values in such a way
 	// that the buttons on the shield, and the digital
@@ -219,7 +219,7 @@ void CButtonController::processFast()
 		m_buttonRead1 = rawButtons;
 		m_buttonRead2 = 0;
 
-		m_debounceTime = curMillies + BC_DEBOUNCE_DELAY;
+		m_debounceStart = curMillies;
 		m_state = state_2;
 		return;
 	}
@@ -228,7 +228,7 @@ void CButtonController::processFast()
 	if(m_state == state_2)
 	{
 		// Have we waited long enough?
-		if(curMillies < m_debounceTime)
+		if((curMillies - m_debounceStart) < BC_DEBOUNCE_DELAY)
 			return;
 
 		// Read them again
@@ -262,7 +262,7 @@ void CButtonController::processFast()
 }
 
 // Return ms since button pressed - 0 = not pressed
-unsigned long CButtonController::getButton(int _buttonID)
+uint32_t CButtonController::getButton(int _buttonID)
 {
 	if(m_maskButtonsUntilClear)
 		return 0;
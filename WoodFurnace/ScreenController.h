@@ -37,12 +37,12 @@ protected:
 	Button_stateE m_state;
 	int m_buttonRead1;
 	int m_buttonRead2;
-	unsigned long m_debounceTime;
+	uint32_t m_debounceStart;
 
 	bool m_maskButtonsUntilClear;
 
 	// This array stores the millis() from when the button was pressed
-	unsigned long m_buttons[BC_NBUTTONS];
+	uint32_t m_buttons[BC_NBUTTONS];
 
 public:
 
@@ -54,7 +54,7 @@ public:
 	void processFast();
 	void processOneSecond() {}
 
-	unsigned long getButton(int _buttonID);	// Return ms since button pressed - 0 = not pressed
+	uint32_t getButton(int _buttonID);		// Return ms since button pressed - 0 = not pressed
 	bool anyButtonsPressed();				// Bitmap mask of buttons currently pressed
 	void maskButtonsUntilClear();
 };
@@ -84,7 +84,7 @@ public:
 
 	virtual void init() = 0;
 
-	virtual void processOneSecond() = 0;
+	virtual void processDisplay() = 0;
 
 	virtual void buttonCheck(CButtonController &_buttons) = 0;
 };
@@ -113,7 +113,7 @@ public:
 	int currentScreen() { return m_screenID; }
 
 	void processFast();
-	void processOneSecond();
+	void processDisplay();
 };
 
 #endif
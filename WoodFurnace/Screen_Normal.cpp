@@ -7,15 +7,22 @@
 #include <Adafruit_RGBLCDShield.h>
 #include <utility/Adafruit_MCP23017.h>
 
-#include <PID_v1.h>
 
 #include "Pins.h"
 #include "Defs.h"
 #include "MilliTimer.h"
 #include "Settings.h"
+#include "SensorFilter.h"
 #include "TempSensor_Thermocouple.h"
+#include "ThermocoupleBus.h"
+#include "TempSensor_Thermistor.h"
+#include "TempSensorManager.h"
 #include "PWMMotor.h"
 #include "WSPID.h"
+#include "SetpointRamp.h"
+#include "SmithPredictor.h"
+#include "PlantEstimator.h"
+#include "RelayAutotune.h"
 #include "Beeper.h"
 #include "FanController.h"
 #include "ScreenController.h"
@@ -27,7 +34,7 @@
 extern Adafruit_RGBLCDShield g_lcd;
 extern const char *degreeSymbol;
 
-extern CTempSensor_Thermocouple g_thermocouple;
+extern CTempSensorManager g_tempSensors;
 extern CWoodStoveSettings g_woodStoveSettings;
 extern CPWMMotor g_forcedDraftMotor;
 extern CBeeper g_beeper;
@@ -100,7 +107,7 @@ void CScreen_Normal::updateDynamics()
 #endif
 
 	// Actual temp
-	int temperature = g_thermocouple.temperature();
+	int temperature = g_tempSensors.temperature(TEMP_SENSOR_FLUE);
 	if(m_lastFlueTemp != temperature)
 	{
 		g_lcd.setCursor(5, 0);
@@ -210,6 +217,10 @@ void CScreen_Normal::updateDynamics()
 		case CTempController::state_airBoost:
 			g_lcd.print(F("B"));
 			break;
+
+		case CTempController::state_autotune:
+			g_lcd.print(F("T"));
+			break;
 		}
 	}
 	else
@@ -248,7 +259,7 @@ void CScreen_Normal::buttonCheck(CButtonController &_buttons)
 	}
 }
 
-void CScreen_Normal::processOneSecond()
+void CScreen_Normal::processDisplay()
 {
 	updateDynamics();
 }
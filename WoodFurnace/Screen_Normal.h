@@ -28,7 +28,7 @@ public:
 	void init();
 
 	void buttonCheck(CButtonController &_buttons);
-	void processOneSecond();
+	void processDisplay();
 };
 
 #endif
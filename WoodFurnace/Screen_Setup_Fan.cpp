@@ -172,7 +172,7 @@ void CScreen_Setup_Fan::buttonCheck(CButtonController &_buttons)
 		updateDynamics();
 }
 
-void CScreen_Setup_Fan::processOneSecond()
+void CScreen_Setup_Fan::processDisplay()
 {
 //	updateDynamics();
 }
@@ -31,7 +31,7 @@ public:
 	void init();
 
 	void buttonCheck(CButtonController &_buttons);
-	void processOneSecond();
+	void processDisplay();
 };
 
 #endif
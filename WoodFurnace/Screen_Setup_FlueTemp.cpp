@@ -226,7 +226,7 @@ void CScreen_Setup_FlueTemp::buttonCheck(CButtonController &_buttons)
 	}
 }
 
-void CScreen_Setup_FlueTemp::processOneSecond()
+void CScreen_Setup_FlueTemp::processDisplay()
 {
 //	updateDynamics();
 }
@@ -32,7 +32,7 @@ public:
 	void init();
 
 	void buttonCheck(CButtonController &_buttons);
-	void processOneSecond();
+	void processDisplay();
 };
 
 #endif
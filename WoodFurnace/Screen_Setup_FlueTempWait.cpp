@@ -132,7 +132,7 @@ void CScreen_Setup_FlueTempWait::buttonCheck(CButtonController &_buttons)
 		updateDynamics();
 }
 
-void CScreen_Setup_FlueTempWait::processOneSecond()
+void CScreen_Setup_FlueTempWait::processDisplay()
 {
 //	updateDynamics();
 }
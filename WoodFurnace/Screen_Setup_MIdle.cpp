@@ -6,15 +6,22 @@
 #include <Wire.h>
 #include <Adafruit_RGBLCDShield.h>
 #include <utility/Adafruit_MCP23017.h>
-#include <PID_v1.h>
 
 #include "Pins.h"
 #include "Defs.h"
 
 #include "MilliTimer.h"
 #include "WSPID.h"
+#include "SetpointRamp.h"
+#include "SmithPredictor.h"
+#include "PlantEstimator.h"
+#include "RelayAutotune.h"
 #include "TempController.h"
+#include "SensorFilter.h"
 #include "TempSensor_Thermocouple.h"
+#include "ThermocoupleBus.h"
+#include "TempSensor_Thermistor.h"
+#include "TempSensorManager.h"
 
 #include "ScreenController.h"
 #include "Screen_Setup_MIdle.h"
@@ -23,7 +30,7 @@
 extern Adafruit_RGBLCDShield g_lcd;
 extern CScreenController g_screenController;
 extern CTempController g_tempController;
-extern CTempSensor_Thermocouple g_thermocouple;
+extern CTempSensorManager g_tempSensors;
 
 ////////////////////////////////////////////////////////////
 // Setup forced draft fixed (non-PID) in idle
@@ -69,7 +76,7 @@ void CScreen_Setup_MIdle::updateDynamics()
 	g_lcd.setCursor(13, 1);
 	g_lcd.print(F("   "));
 	g_lcd.setCursor(13, 1);
-	g_lcd.print(g_thermocouple.temperature());
+	g_lcd.print(g_tempSensors.temperature(TEMP_SENSOR_FLUE));
 
 	// Now put the cursor on the value
 	int idleSpeedOverride = g_tempController.getIdleSpeedOverride();
@@ -153,7 +160,7 @@ void CScreen_Setup_MIdle::updateValue()
 		g_lcd.setCursor(9,1);
 }
 
-void CScreen_Setup_MIdle::processOneSecond()
+void CScreen_Setup_MIdle::processDisplay()
 {
 	updateDynamics();
 }
@@ -25,7 +25,7 @@ class CScreen_Setup_MIdle : public CScreen_Base
 	void init();
 
 	void buttonCheck(CButtonController &_buttons);
-	void processOneSecond();
+	void processDisplay();
 };
 
 #endif
@@ -11,11 +11,21 @@
 #include "Defs.h"
 #include "MilliTimer.h"
 
+#include "SensorFilter.h"
 #include "TempSensor_Thermocouple.h"
+#include "ThermocoupleBus.h"
+#include "TempSensor_Thermistor.h"
+#include "TempSensorManager.h"
 #include "ScreenController.h"
-#include "Screen_Setup_PID.h"
 #include "Settings.h"
 #include "PWMMotor.h"
+#include "WSPID.h"
+#include "SetpointRamp.h"
+#include "SmithPredictor.h"
+#include "PlantEstimator.h"
+#include "RelayAutotune.h"
+#include "TempController.h"
+#include "Screen_Setup_PID.h"
 
 extern Adafruit_RGBLCDShield g_lcd;
 extern const char *degreeSymbol;
@@ -24,9 +34,10 @@ extern CWoodStoveSettings g_woodStoveSettings;
 extern CScreenController g_screenController;
 extern void pidSettingsChanged();
 extern CPWMMotor g_forcedDraftMotor;
+extern CTempController g_tempController;
 
 extern const char *degreeSymbol;
-extern CTempSensor_Thermocouple g_thermocouple;
+extern CTempSensorManager g_tempSensors;
 ////////////////////////////////////////////////////////////
 // Display PID control values
 ////////////////////////////////////////////////////////////
@@ -46,7 +57,8 @@ void CScreen_Setup_PID::init()
 	printUptime();
 	Serial.println(F("CScreen_Setup_PID::init()"));
 #endif
-	m_field = field_PID_Kp;
+	m_field = field_PID_idleKp;
+	m_tuneState = g_tempController.getAutotune().getState();
 
 	g_lcd.clear();
 	g_lcd.cursor();
@@ -65,7 +77,38 @@ void CScreen_Setup_PID::updateStatics()
 
 
 	g_lcd.setCursor(0, 0);
-	g_lcd.print(F("Setup:Flue PID"));
+	g_lcd.print(F("                "));
+	g_lcd.setCursor(0, 0);
+
+	// When there are autotune results, show them up here
+	// where they can be compared against the current gains
+	CRelayAutotune &autotune = g_tempController.getAutotune();
+	if(autotune.getState() == CRelayAutotune::state_done)
+	{
+		g_lcd.print(F("P"));
+		g_lcd.print(autotune.getKp() / FLUE_PID_SCALE, 1);
+		g_lcd.print(F(" I"));
+		g_lcd.print(autotune.getKi() / FLUE_PID_SCALE, 2);
+		g_lcd.print(F(" D"));
+		g_lcd.print(autotune.getKd() / FLUE_PID_SCALE, 0);
+	}
+	else if(m_field == field_PID_Tune)
+	{
+		g_lcd.print(F("Setup:Autotune"));
+	}
+	else
+	{
+		g_lcd.print((gainSet() == PID_GAINS_RUN) ? F("Setup:Run PID") : F("Setup:Idle PID"));
+	}
+}
+
+// Which set of gains the current field belongs to
+int CScreen_Setup_PID::gainSet()
+{
+	if((m_field >= field_PID_runKp) && (m_field <= field_PID_runKd))
+		return PID_GAINS_RUN;
+
+	return PID_GAINS_IDLE;
 }
 
 void CScreen_Setup_PID::updateDynamics()
@@ -76,27 +119,55 @@ void CScreen_Setup_PID::updateDynamics()
 #endif
 
 	// Now display the P/I/D value depending on field selection
+	int set = gainSet();
 	g_lcd.setCursor(2, 1);
 	g_lcd.print("     ");
 	switch(m_field)
 	{
 	default:
-	case field_PID_Kp:
+	case field_PID_idleKp:
+	case field_PID_runKp:
 		g_lcd.setCursor(0, 1);
 		g_lcd.print(F("P:"));
-		g_lcd.print(g_settings.m_Kp, 2);
+		g_lcd.print(g_settings.m_Kp[set], 2);
 		break;
 
-	case field_PID_Ki:
+	case field_PID_idleKi:
+	case field_PID_runKi:
 		g_lcd.setCursor(0, 1);
 		g_lcd.print(F("I:"));
-		g_lcd.print(g_settings.m_Ki, 2);
+		g_lcd.print(g_settings.m_Ki[set], 2);
 		break;
 
-	case field_PID_Kd:
+	case field_PID_idleKd:
+	case field_PID_runKd:
 		g_lcd.setCursor(0, 1);
 		g_lcd.print(F("D:"));
-		g_lcd.print(g_settings.m_Kd, 2);
+		g_lcd.print(g_settings.m_Kd[set], 2);
+		break;
+
+	case field_PID_Tune:
+		g_lcd.setCursor(0, 1);
+		g_lcd.print(F("T:"));
+		switch(g_tempController.getAutotune().getState())
+		{
+		default:
+		case CRelayAutotune::state_off:
+			g_lcd.print(F("Go?"));	// Up to start
+			break;
+
+		case CRelayAutotune::state_running:
+			g_lcd.print(F("Run"));	// Down to cancel
+			break;
+
+		case CRelayAutotune::state_done:
+			g_lcd.print(F("Ok?"));	// Up to accept, down to reject
+			break;
+
+		case CRelayAutotune::state_failed:
+			g_lcd.print(F("Err"));
+			break;
+		}
 		break;
 	};
 
@@ -130,13 +201,9 @@ void CScreen_Setup_PID::buttonCheck(CButtonController &_buttons)
 #endif
 		g_settings.saveSettings();
 
-		if(m_field == field_PID_Kp)
-			m_field = field_PID_Kd;
-		else if(m_field == field_PID_Ki)
-			m_field = field_PID_Kp;
-		else if(m_field == field_PID_Kd)
-			m_field = field_PID_Ki;
+		m_field = (CScreen_Setup_PID_FieldE)((m_field + field_PID_count - 1) % field_PID_count);
 
+		updateStatics();
 		updateDynamics();
 		_buttons.maskButtonsUntilClear();
 	}
@@ -149,27 +216,31 @@ void CScreen_Setup_PID::buttonCheck(CButtonController &_buttons)
 #endif
 		g_settings.saveSettings();
 
-		if(m_field == field_PID_Kp)
-			m_field = field_PID_Ki;
-		else if(m_field == field_PID_Ki)
-			m_field = field_PID_Kd;
-		else if(m_field == field_PID_Kd)
-			m_field = field_PID_Kp;
+		m_field = (CScreen_Setup_PID_FieldE)((m_field + 1) % field_PID_count);
 
+		updateStatics();
 		updateDynamics();
 		_buttons.maskButtonsUntilClear();
 	}
 
+	// The autotune field has its own buttons
+	if(m_field == field_PID_Tune)
+	{
+		tuneButtonCheck(_buttons);
+		return;
+	}
+
 	// Figure which value are we going to change
+	int set = gainSet();
 	float *targetValue = 0;
-	if(m_field == field_PID_Kp)
-		targetValue = &g_settings.m_Kp;
+	if((m_field == field_PID_idleKp) || (m_field == field_PID_runKp))
+		targetValue = &g_settings.m_Kp[set];
 
-	if(m_field == field_PID_Ki)
-		targetValue = &g_settings.m_Ki;
+	if((m_field == field_PID_idleKi) || (m_field == field_PID_runKi))
+		targetValue = &g_settings.m_Ki[set];
 
-	if(m_field == field_PID_Kd)
-		targetValue = &g_settings.m_Kd;
+	if((m_field == field_PID_idleKd) || (m_field == field_PID_runKd))
+		targetValue = &g_settings.m_Kd[set];
 
 	if(!targetValue)
 	{
@@ -212,9 +283,7 @@ void CScreen_Setup_PID::buttonCheck(CButtonController &_buttons)
 		updateDisplay = true;
 	}
 
-	if(g_settings.m_Kp < 0.) g_settings.m_Kp = 0.;
-	if(g_settings.m_Ki < 0.) g_settings.m_Ki = 0.;
-	if(g_settings.m_Kd < 0.) g_settings.m_Kd = 0.;
+	if((*targetValue) < 0.) (*targetValue) = 0.;
 
 	if(updateDisplay)
 	{
@@ -225,6 +294,53 @@ void CScreen_Setup_PID::buttonCheck(CButtonController &_buttons)
 	}
 }
 
+void CScreen_Setup_PID::tuneButtonCheck(CButtonController &_buttons)
+{
+	CRelayAutotune &autotune = g_tempController.getAutotune();
+
+	// Up starts a run, or accepts the results of one
+	if(_buttons.getButton(BC_BUTTON_UP) > 0)
+	{
+#ifdef DEBUG_SCREEN_SETUP_PID
+		printUptime();
+		Serial.println(F("CScreen_Setup_PID::tuneButtonCheck - up"));
+#endif
+		if(autotune.getState() == CRelayAutotune::state_done)
+			g_tempController.acceptAutotune();
+		else if(autotune.getState() != CRelayAutotune::state_running)
+			g_tempController.startAutotune();
+
+		updateTuneInfo();
+		_buttons.maskButtonsUntilClear();
+	}
+
+	// Down cancels a run, or throws the results away
+	if(_buttons.getButton(BC_BUTTON_DOWN) > 0)
+	{
+#ifdef DEBUG_SCREEN_SETUP_PID
+		printUptime();
+		Serial.println(F("CScreen_Setup_PID::tuneButtonCheck - down"));
+#endif
+		g_tempController.cancelAutotune();
+
+		updateTuneInfo();
+		_buttons.maskButtonsUntilClear();
+	}
+}
+
+void CScreen_Setup_PID::updateTuneInfo()
+{
+	// Redraw when the autotuner changes state (it finishes
+	// on its own, so this is checked every second too)
+	int tuneState = g_tempController.getAutotune().getState();
+	if(tuneState == m_tuneState)
+		return;
+
+	m_tuneState = tuneState;
+	updateStatics();
+	updateDynamics();
+}
+
 void CScreen_Setup_PID::updatePTInfo()
 {
 	// Display PWM output
@@ -238,7 +354,7 @@ void CScreen_Setup_PID::updatePTInfo()
 	g_lcd.print(F("    "));
 	g_lcd.setCursor(12, 1);
 
-	int temperature = g_thermocouple.temperature();
+	int temperature = g_tempSensors.temperature(TEMP_SENSOR_FLUE);
 	if(temperature == THERMOCOUPLE_INVALID_TEMP)
 		g_lcd.print(F("---"));
 	else
@@ -248,7 +364,8 @@ void CScreen_Setup_PID::updatePTInfo()
 	g_lcd.setCursor(5, 1);
 }
 
-void CScreen_Setup_PID::processOneSecond()
+void CScreen_Setup_PID::processDisplay()
 {
+	updateTuneInfo();
 	updatePTInfo();
 }
@@ -13,17 +13,29 @@ protected:
 
 	typedef enum
 	{
-		field_PID_Kp = 0,
-		field_PID_Ki,
-		field_PID_Kd,
+		field_PID_idleKp = 0,
+		field_PID_idleKi,
+		field_PID_idleKd,
+		field_PID_runKp,
+		field_PID_runKi,
+		field_PID_runKd,
+		field_PID_Tune,
+		field_PID_count,
 	} CScreen_Setup_PID_FieldE;
 	CScreen_Setup_PID_FieldE m_field;	// Which field are we editing?
 
 	CMilliTimer m_buttonTimer;
 
+	// Autotune state last shown, so we know when to redraw
+	int m_tuneState;
+
+	int gainSet();
+
 	void updateStatics();
 	void updateDynamics();
 	void updatePTInfo();
+	void updateTuneInfo();
+	void tuneButtonCheck(CButtonController &_buttons);
 public:
 
 	CScreen_Setup_PID(int _id);
@@ -32,7 +44,7 @@ public:
 	void init();
 
 	void buttonCheck(CButtonController &_buttons);
-	void processOneSecond();
+	void processDisplay();
 };
 
 #endif
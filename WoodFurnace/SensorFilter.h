@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////
+// Composable sensor filters
+////////////////////////////////////////////////////////////
+#ifndef SensorFilter_h
+#define SensorFilter_h
+
+////////////////////////////////////////////////////////////
+// Each stage takes a sample (fixed point, same units in and
+// out) and the time in ms since the previous sample, and
+// returns the filtered value. Stages are chained at compile
+// time with CSensorFilterChain, so there are no virtual calls
+// and no heap; any per-stage history lives in a fixed array.
+////////////////////////////////////////////////////////////
+
+////////////////////////////////////////////////////////////
+// Does nothing, used to fill unused slots in a chain
+class CPassFilter
+{
+public:
+	void reset(int32_t _value) { UNUSED(_value); }
+	int32_t process(int32_t _sample, uint32_t _dt) { UNUSED(_dt); return _sample; }
+};
+
+////////////////////////////////////////////////////////////
+// Median of the last N samples. Throws out single
+// sample spikes (N = 3) or pairs of them (N = 5).
+template <int N>
+class CMedianFilter
+{
+protected:
+	int32_t m_ring[N];
+	unsigned char m_head;
+
+public:
+	CMedianFilter() { reset(0); }
+
+	void reset(int32_t _value)
+	{
+		for(int _ = 0; _ < N; ++_)
+			m_ring[_] = _value;
+		m_head = 0;
+	}
+
+	int32_t process(int32_t _sample, uint32_t _dt)
+	{
+		UNUSED(_dt);
+
+		m_ring[m_head] = _sample;
+		if(++m_head >= N)
+			m_head = 0;
+
+		// Insertion sort a copy, N is tiny
+		int32_t sorted[N];
+		for(int i = 0; i < N; ++i)
+		{
+			int j = i;
+			while((j > 0) && (sorted[j - 1] > m_ring[i]))
+			{
+				sorted[j] = sorted[j - 1];
+				--j;
+			}
+			sorted[j] = m_ring[i];
+		}
+
+		return sorted[N / 2];
+	}
+};
+
+////////////////////////////////////////////////////////////
+// Exponential moving average. ALPHA is the weight of the
+// new sample in Q8 (256 == 1.0). The step is rounded, not
+// floored, or the output would settle up to 256 / ALPHA
+// counts below a steady input but right on one from above.
+template <int32_t ALPHA>
+class CEMAFilter
+{
+protected:
+	int32_t m_value;
+
+public:
+	CEMAFilter() { reset(0); }
+
+	void reset(int32_t _value) { m_value = _value; }
+
+	int32_t process(int32_t _sample, uint32_t _dt)
+	{
+		UNUSED(_dt);
+
+		m_value += ((_sample - m_value) * ALPHA + 128) >> 8;
+		return m_value;
+	}
+};
+
+////////////////////////////////////////////////////////////
+// Limit how fast the output can move. MAX_PER_SEC is in
+// the same units as the samples. Gaps longer than a second
+// are held to a second, both so MAX_PER_SEC * dt can't
+// overflow a long and because after a long gap the output
+// should still walk, not jump, to the new reading.
+template <int32_t MAX_PER_SEC>
+class CSlewLimiter
+{
+protected:
+	int32_t m_value;
+
+public:
+	CSlewLimiter() { reset(0); }
+
+	void reset(int32_t _value) { m_value = _value; }
+
+	int32_t process(int32_t _sample, uint32_t _dt)
+	{
+		if(_dt > (uint32_t)ONE_SECOND_MS)
+			_dt = ONE_SECOND_MS;
+
+		int32_t maxStep = (MAX_PER_SEC * (int32_t)_dt) / ONE_SECOND_MS;
+
+		if(_sample > m_value + maxStep)
+			m_value += maxStep;
+		else if(_sample < m_value - maxStep)
+			m_value -= maxStep;
+		else
+			m_value = _sample;
+
+		return m_value;
+	}
+};
+
+////////////////////////////////////////////////////////////
+// Run the stages in order
+template <class S1, class S2 = CPassFilter, class S3 = CPassFilter>
+class CSensorFilterChain
+{
+protected:
+	S1 m_stage1;
+	S2 m_stage2;
+	S3 m_stage3;
+
+public:
+	void reset(int32_t _value)
+	{
+		m_stage1.reset(_value);
+		m_stage2.reset(_value);
+		m_stage3.reset(_value);
+	}
+
+	int32_t process(int32_t _sample, uint32_t _dt)
+	{
+		return m_stage3.process(m_stage2.process(m_stage1.process(_sample, _dt), _dt), _dt);
+	}
+};
+
+#endif
@@ -0,0 +1,72 @@
+////////////////////////////////////////////////////////////
+// Setpoint trajectory generator
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+
+#include "SetpointRamp.h"
+
+// Fraction of the ramp done, Q16
+#define RAMP_FRACTION_SHIFT	(16)
+#define RAMP_FRACTION_ONE	((int32_t)1 << RAMP_FRACTION_SHIFT)
+
+CSetpointRamp::CSetpointRamp()
+{
+	m_start = m_target = m_setpoint = 0;
+	m_duration = m_elapsed = 0;
+	m_sCurve = false;
+}
+
+CSetpointRamp::~CSetpointRamp()
+{
+}
+
+void CSetpointRamp::start(int32_t _from, int32_t _to, int _degPerMinute, bool _sCurve)
+{
+	if(_degPerMinute <= 0)
+	{
+		jumpTo(_to);
+		return;
+	}
+
+	int32_t distance = labs(_to - _from);
+
+	m_start = m_setpoint = _from;
+	m_target = _to;
+	m_sCurve = _sCurve;
+	m_elapsed = 0;
+
+	// Q8 degrees over Q8 degrees per second
+	m_duration = (uint32_t)((distance * 60) / ((int32_t)_degPerMinute * 256));
+}
+
+void CSetpointRamp::jumpTo(int32_t _setpoint)
+{
+	m_start = m_target = m_setpoint = _setpoint;
+	m_duration = m_elapsed = 0;
+}
+
+int32_t CSetpointRamp::processOneSecond()
+{
+	if(!isRamping())
+	{
+		m_setpoint = m_target;
+		return m_setpoint;
+	}
+
+	m_elapsed++;
+
+	int32_t u = (int32_t)(((int64_t)m_elapsed << RAMP_FRACTION_SHIFT) / m_duration);
+
+	// Smoothstep, 3u^2 - 2u^3
+	if(m_sCurve)
+	{
+		int64_t u2 = ((int64_t)u * u) >> RAMP_FRACTION_SHIFT;
+		int64_t u3 = (u2 * u) >> RAMP_FRACTION_SHIFT;
+		u = (int32_t)(3 * u2 - 2 * u3);
+	}
+
+	m_setpoint = m_start + (int32_t)(((int64_t)(m_target - m_start) * u) >> RAMP_FRACTION_SHIFT);
+	return m_setpoint;
+}
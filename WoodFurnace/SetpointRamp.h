@@ -0,0 +1,44 @@
+////////////////////////////////////////////////////////////
+// Setpoint trajectory generator
+////////////////////////////////////////////////////////////
+#ifndef SetpointRamp_h
+#define SetpointRamp_h
+
+////////////////////////////////////////////////////////////
+// Moves a setpoint toward its target at a limited rate
+// instead of in one step. The linear ramp moves at a steady
+// rate. The S-curve takes the same time but starts and ends
+// gently (smoothstep), so the blower isn't kicked at either
+// end. Setpoints are Q8, the same as the PID's.
+////////////////////////////////////////////////////////////
+class CSetpointRamp
+{
+protected:
+	int32_t m_start;		// Q8
+	int32_t m_target;		// Q8
+	int32_t m_setpoint;		// Q8
+
+	uint32_t m_duration;	// Seconds
+	uint32_t m_elapsed;		// Seconds
+
+	bool m_sCurve;
+
+public:
+	CSetpointRamp();
+	virtual ~CSetpointRamp();
+
+	// Ramp from _from to _to at _degPerMinute (0 steps)
+	void start(int32_t _from, int32_t _to, int _degPerMinute, bool _sCurve);
+
+	// Go straight to _setpoint
+	void jumpTo(int32_t _setpoint);
+
+	// Call once per second, returns the new setpoint
+	int32_t processOneSecond();
+
+	int32_t getSetpoint() { return m_setpoint; }
+	int32_t getTarget() { return m_target; }
+	bool isRamping() { return m_elapsed < m_duration; }
+};
+
+#endif
@@ -31,9 +31,12 @@ void CWoodStoveSettings::setDefaults()
 	m_fanOffTemp = DEF_FAN_OFF_TEMP;	// Temp below which the fan is turned off
 
 	// Coefs for the flue temp PID
-	m_Kp = DEF_KP;
-	m_Ki = DEF_KI;
-	m_Kd = DEF_KD;
+	for(int _ = 0; _ < PID_GAINS_COUNT; ++_)
+	{
+		m_Kp[_] = DEF_KP;
+		m_Ki[_] = DEF_KI;
+		m_Kd[_] = DEF_KD;
+	}
 }
 
 CWoodStoveSettings::~CWoodStoveSettings()
@@ -42,6 +45,18 @@ CWoodStoveSettings::~CWoodStoveSettings()
 
 void CWoodStoveSettings::loadSettings()
 {
+	// Version 1 had a single set of gains, bring it forward
+	// instead of throwing away a tune that is known to work
+	if(s_saveController.getDataVersion() == 1)
+	{
+#ifdef DEBUG_SETTINGS
+		printUptime();
+		Serial.println(F("CWoodStoveSettings::loadSettings - converting data version 1"));
+#endif
+		loadVersion1();
+		saveSettings();
+	}
+
 	// Make sure we have the correct data version
 	if(s_saveController.getDataVersion() != WOODSTOVE_DATA_VERSION)
 	{
@@ -79,10 +94,12 @@ void CWoodStoveSettings::loadSettings()
 	m_fanOffTemp = s_saveController.readInt();
 
 	// Coefs for the flue temp PID
-	m_Kp = s_saveController.readFloat();
-	m_Ki = s_saveController.readFloat();
-	m_Kd = s_saveController.readFloat();
-
+	for(int _ = 0; _ < PID_GAINS_COUNT; ++_)
+	{
+		m_Kp[_] = s_saveController.readFloat();
+		m_Ki[_] = s_saveController.readFloat();
+		m_Kd[_] = s_saveController.readFloat();
+	}
 
 #ifdef DEBUG_SETTINGS
 	printUptime();
@@ -106,15 +123,42 @@ void CWoodStoveSettings::loadSettings()
 	Serial.print(F("CWoodStoveSettings::loadSettings - m_fanOffTemp: "));
 	Serial.println(m_fanOffTemp);
 
-	Serial.print(F("CWoodStoveSettings::loadSettings - m_Kp: "));
-	Serial.println(m_Kp);
+	for(int _ = 0; _ < PID_GAINS_COUNT; ++_)
+	{
+		Serial.print(F("CWoodStoveSettings::loadSettings - gains["));
+		Serial.print(_);
+		Serial.print(F("] Kp: "));
+		Serial.print(m_Kp[_]);
+		Serial.print(F(" Ki: "));
+		Serial.print(m_Ki[_]);
+		Serial.print(F(" Kd: "));
+		Serial.println(m_Kd[_]);
+	}
+#endif
+}
 
-	Serial.print(F("CWoodStoveSettings::loadSettings - m_Ki: "));
-	Serial.println(m_Ki);
+// Same layout as version 2 except there was only one set of
+// gains. Use it for both idle and run.
+void CWoodStoveSettings::loadVersion1()
+{
+	s_saveController.rewind();
 
-	Serial.print(F("CWoodStoveSettings::loadSettings - m_Kd: "));
-	Serial.println(m_Kd);
-#endif
+	m_targetIdleTemp = s_saveController.readInt();
+	m_targetRunTemp = s_saveController.readInt();
+	m_alarmFlueTemp = s_saveController.readInt();
+	m_flueTempWaitTime = s_saveController.readInt();
+	m_fanOnTemp = s_saveController.readInt();
+	m_fanOffTemp = s_saveController.readInt();
+
+	float kp = s_saveController.readFloat();
+	float ki = s_saveController.readFloat();
+	float kd = s_saveController.readFloat();
+	for(int _ = 0; _ < PID_GAINS_COUNT; ++_)
+	{
+		m_Kp[_] = kp;
+		m_Ki[_] = ki;
+		m_Kd[_] = kd;
+	}
 }
 
 void CWoodStoveSettings::saveSettings(bool _saveDefaults)
@@ -148,9 +192,12 @@ void CWoodStoveSettings::saveSettings(bool _saveDefaults)
 	s_saveController.writeInt(m_fanOffTemp);
 
 	// Coefs for the flue temp PID
-	s_saveController.writeFloat(m_Kp);
-	s_saveController.writeFloat(m_Ki);
-	s_saveController.writeFloat(m_Kd);
+	for(int _ = 0; _ < PID_GAINS_COUNT; ++_)
+	{
+		s_saveController.writeFloat(m_Kp[_]);
+		s_saveController.writeFloat(m_Ki[_]);
+		s_saveController.writeFloat(m_Kd[_]);
+	}
 }
 
 
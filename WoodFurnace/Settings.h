@@ -5,6 +5,7 @@ class CWoodStoveSettings
 {
 protected:
 	void setDefaults();
+	void loadVersion1();
 
 public:
 
@@ -22,10 +23,10 @@ public:
 	int m_fanOnTemp;	// Temp at which the fan comes on
 	int m_fanOffTemp;	// Temp below which the fan is turned off
 
-	// Coefs for the flue temp PID
-	float m_Kp;
-	float m_Ki;
-	float m_Kd;
+	// Coefs for the flue temp PID, indexed by PID_GAINS_xxx
+	float m_Kp[PID_GAINS_COUNT];
+	float m_Ki[PID_GAINS_COUNT];
+	float m_Kd[PID_GAINS_COUNT];
 
 	CWoodStoveSettings();
 	virtual ~CWoodStoveSettings();
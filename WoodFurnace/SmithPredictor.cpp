@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////
+// Smith predictor for the flue's transport delay
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+#include "WSPID.h"
+
+#include "SmithPredictor.h"
+
+#define SMITH_GAIN_SHIFT	(16)
+#define SMITH_GAIN_ONE		((int32_t)1 << SMITH_GAIN_SHIFT)
+
+CSmithPredictor::CSmithPredictor()
+{
+	m_gain = 0;
+	m_timeConstant = ONE_SECOND_MS;
+	m_deadTime = 0;
+
+	reset();
+}
+
+CSmithPredictor::~CSmithPredictor()
+{
+}
+
+void CSmithPredictor::setModel(double _gain, int32_t _timeConstant, int _deadTime)
+{
+	if((_gain < 0.) || (_timeConstant <= 0) || (_deadTime < 1))
+		return;
+
+	m_gain = (int32_t)(_gain * SMITH_GAIN_ONE + 0.5);
+	m_timeConstant = _timeConstant;
+	m_deadTime = min(_deadTime, SMITH_MAX_DEAD_TIME);
+
+	reset();
+}
+
+void CSmithPredictor::reset()
+{
+	m_model = m_delayed = 0;
+	for(int _ = 0; _ < SMITH_MAX_DEAD_TIME; ++_)
+		m_history[_] = 0;
+	m_head = 0;
+
+	m_lastSequence = 0;
+	m_lastSampleTime = 0;
+}
+
+int32_t CSmithPredictor::process(uint32_t _sequence, uint32_t _sampleTime, int _output)
+{
+	// Nothing new, nothing to do
+	if((_sequence == m_lastSequence) || (m_deadTime < 1))
+		return m_model - m_delayed;
+
+	// Same dt handling as the PID, a late sample doesn't
+	// get to move the model a long way
+	int32_t dt = (int32_t)(_sampleTime - m_lastSampleTime);
+	if((dt <= 0) || (dt > (2L * ONE_SECOND_MS)))
+		dt = ONE_SECOND_MS;
+
+	m_lastSequence = _sequence;
+	m_lastSampleTime = _sampleTime;
+
+	// First order lag toward gain * output. The step is held to
+	// +/- 1024F so times a dt of at most 2 s it fits in 32 bits.
+	int32_t target = (m_gain * _output) >> (SMITH_GAIN_SHIFT - WSPID_FIXED_SHIFT);
+	int32_t step = constrain(target - m_model, -WSPID_SIGNAL_MAX, WSPID_SIGNAL_MAX);
+	m_model += (step * dt) / m_timeConstant;
+
+	// The oldest entry is the model m_deadTime samples ago,
+	// take it out and put the new one in its place
+	m_delayed = (int32_t)m_history[m_head] << (WSPID_FIXED_SHIFT - SMITH_HISTORY_SHIFT);
+	m_history[m_head] = (int)(m_model >> (WSPID_FIXED_SHIFT - SMITH_HISTORY_SHIFT));
+	m_head = (m_head + 1) % m_deadTime;
+
+	return m_model - m_delayed;
+}
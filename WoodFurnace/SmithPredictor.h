@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////
+// Smith predictor for the flue's transport delay
+////////////////////////////////////////////////////////////
+#ifndef SmithPredictor_h
+#define SmithPredictor_h
+
+#define SMITH_MAX_DEAD_TIME		(60)	// Samples the delay line can hold
+
+// The model history is kept as ints in 1/16ths of a degree,
+// plenty for a model and half the RAM of Q8 longs
+#define SMITH_HISTORY_SHIFT		(4)
+
+////////////////////////////////////////////////////////////
+// The flue sees a change at the fire ~30 seconds late, and a
+// PID tuned around that delay has to be slow. The predictor
+// runs a first order model of the stove (the same plant
+// CStoveSim simulates) twice: once now, and once delayed by
+// the dead time. The PID is fed the measured flue plus
+// (undelayed model - delayed model), so it sees what the flue
+// will be doing once the delay has passed. If the model is
+// right the delayed model cancels the delay out of the loop.
+// If it is wrong the measurement still corrects it, so there
+// is no steady state error, just a slower loop.
+//
+// The model is in deviation form (degrees above where the
+// stove would sit with the blower off), so ambient and the
+// idle burn cancel out of the correction.
+////////////////////////////////////////////////////////////
+class CSmithPredictor
+{
+protected:
+	int32_t m_gain;			// Q16 degrees F per PWM count, at steady state
+	int32_t m_timeConstant;	// ms
+	int m_deadTime;			// Samples
+
+	int32_t m_model;		// Q8, undelayed model output
+	int32_t m_delayed;		// Q8, model output m_deadTime samples ago
+	int m_history[SMITH_MAX_DEAD_TIME];
+	int m_head;
+
+	uint32_t m_lastSequence;
+	uint32_t m_lastSampleTime;
+
+public:
+	CSmithPredictor();
+	virtual ~CSmithPredictor();
+
+	// _gain in degrees F per PWM count, _timeConstant in ms,
+	// _deadTime in samples. Changing the model restarts it.
+	void setModel(double _gain, int32_t _timeConstant, int _deadTime);
+	void reset();
+
+	// Steps the model when a new sample (_sequence) has arrived,
+	// with the blower command that was applied since the last one.
+	// Returns the correction (Q8) to add to the measured flue.
+	int32_t process(uint32_t _sequence, uint32_t _sampleTime, int _output);
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include <Arduino.h>
 
 #include "Defs.h"
+#include "SensorFilter.h"
 #include "TempSensor_Thermocouple.h"
 
 #include "StoveSim.h"
@@ -49,6 +50,9 @@ CStoveSim::CStoveSim()
 		m_temps[_] = m_curTemp;
 
 	m_forcedDraftSpeed = 0;
+
+	m_sampleTime = 0;
+	m_sampleSequence = 0;
 }
 
 CStoveSim::~CStoveSim()
@@ -63,6 +67,10 @@ void CStoveSim::processOneSecond()
 	Serial.println(m_curTemp);
 #endif
 
+	// The simulated probe delivers a new reading every second
+	m_sampleTime = millis();
+	m_sampleSequence++;
+
 	// Nothing happens if there
 	// is no fire
 	if(m_curTemp == AMBIENT_TEMP)
@@ -158,6 +166,15 @@ int CStoveSim::getTemperature()
 	return (int)m_temps[STOVE_SIM_DELAY_TIME - 1];
 }
 
+int CStoveSim::getFireboxTemperature()
+{
+#ifdef TEST_DEAD_PROBE_ALARM
+	return THERMOCOUPLE_INVALID_TEMP;
+#endif
+
+	return (int)m_curTemp;
+}
+
 double CStoveSim::getFuelLoad()
 {
 	return m_fuelLoad;
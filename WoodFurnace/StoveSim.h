@@ -20,6 +20,9 @@ protected:
 
 	int m_idleTemp;
 
+	uint32_t m_sampleTime;
+	uint32_t m_sampleSequence;
+
 public:
 	CStoveSim();
 	virtual ~CStoveSim();
@@ -29,6 +32,9 @@ public:
 	void setForcedDraftBlower(int _speed);
 	int getPWM();
 	int getTemperature();
+	int getFireboxTemperature();	// What the flue will see STOVE_SIM_DELAY_TIME from now
+	uint32_t getSampleTime() { return m_sampleTime; }
+	uint32_t getSampleSequence() { return m_sampleSequence; }
 	double getFuelLoad();
 
 	void bumpToMinForcedDraftTemp();
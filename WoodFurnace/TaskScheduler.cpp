@@ -0,0 +1,154 @@
+////////////////////////////////////////////////////////////
+// Table driven cooperative task scheduler
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+
+#include "TaskScheduler.h"
+
+CTaskScheduler::CTaskScheduler()
+{
+	m_tasks = 0;
+	m_states = 0;
+	m_nTasks = 0;
+
+	m_lastSkipped = 0;
+
+	m_statsSeconds = 0;
+}
+
+CTaskScheduler::~CTaskScheduler()
+{
+}
+
+void CTaskScheduler::start(const CSchedulerTaskT *_tasks, CSchedulerTaskStateT *_states, int _nTasks, uint32_t _now)
+{
+	m_tasks = _tasks;
+	m_states = _states;
+	m_nTasks = _nTasks;
+
+	for(int _ = 0; _ < m_nTasks; ++_)
+	{
+		CSchedulerTaskStateT &state = m_states[_];
+
+		state.m_nextRun = _now + m_tasks[_].m_phase;
+		state.m_runs = 0;
+		state.m_lateRuns = 0;
+		state.m_skipped = 0;
+		state.m_overruns = 0;
+		state.m_longestRun = 0;
+		state.m_triggered = false;
+	}
+}
+
+bool CTaskScheduler::runNext(uint32_t _now)
+{
+	for(int _ = 0; _ < m_nTasks; ++_)
+	{
+		CSchedulerTaskStateT &state = m_states[_];
+
+		if(!state.m_triggered)
+			continue;
+
+		state.m_triggered = false;
+
+		m_lastSkipped = 0;
+		runTask(_);
+		return true;
+	}
+
+	for(int _ = 0; _ < m_nTasks; ++_)
+	{
+		const CSchedulerTaskT &task = m_tasks[_];
+		CSchedulerTaskStateT &state = m_states[_];
+
+		// Like CMilliTimer, compare elapsed time so this
+		// survives millis() rolling over
+		uint32_t late = _now - state.m_nextRun;
+		if((int32_t)late < 0)
+			continue;
+
+		// Whole periods behind. Up to m_catchUp of them are made up
+		// by leaving the task due for the next passes, the rest are
+		// given up on. Either way the deadline stays on the grid.
+		m_lastSkipped = 0;
+		if(late >= task.m_period)
+		{
+			uint32_t missed = late / task.m_period;
+			if(missed > task.m_catchUp)
+			{
+				m_lastSkipped = missed - task.m_catchUp;
+				state.m_skipped += m_lastSkipped;
+				state.m_nextRun += m_lastSkipped * task.m_period;
+			}
+			state.m_lateRuns++;
+		}
+		state.m_nextRun += task.m_period;
+
+		runTask(_);
+		return true;
+	}
+
+	return false;
+}
+
+void CTaskScheduler::runTask(int _index)
+{
+	CSchedulerTaskStateT &state = m_states[_index];
+
+	uint32_t start = micros();
+	m_tasks[_index].m_function();
+	uint32_t runTime = micros() - start;
+
+	state.m_runs++;
+	if(runTime > m_tasks[_index].m_budget)
+		state.m_overruns++;
+	if(runTime > state.m_longestRun)
+		state.m_longestRun = runTime;
+}
+
+void CTaskScheduler::trigger(CSchedulerTask_functionT _function)
+{
+	for(int _ = 0; _ < m_nTasks; ++_)
+	{
+		if(m_tasks[_].m_function == _function)
+			m_states[_].m_triggered = true;
+	}
+}
+
+void CTaskScheduler::processOneSecond()
+{
+	if(++m_statsSeconds < SCHED_STATS_INTERVAL)
+		return;
+	m_statsSeconds = 0;
+
+#ifdef SERIAL_LOG
+	printStats();
+#endif
+}
+
+void CTaskScheduler::printStats()
+{
+	for(int _ = 0; _ < m_nTasks; ++_)
+	{
+		const CSchedulerTaskT &task = m_tasks[_];
+		CSchedulerTaskStateT &state = m_states[_];
+
+		// TASK, uptime, name, runs, late runs, skipped, overruns, longest run (us)
+		Serial.print(F("TASK, "));
+		printUptime(false);
+		Serial.print(F(", "));
+		Serial.print((const __FlashStringHelper *)task.m_name);
+		Serial.print(F(", "));
+		Serial.print(state.m_runs);
+		Serial.print(F(", "));
+		Serial.print(state.m_lateRuns);
+		Serial.print(F(", "));
+		Serial.print(state.m_skipped);
+		Serial.print(F(", "));
+		Serial.print(state.m_overruns);
+		Serial.print(F(", "));
+		Serial.println(state.m_longestRun);
+	}
+}
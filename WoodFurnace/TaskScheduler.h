@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////
+// Table driven cooperative task scheduler
+////////////////////////////////////////////////////////////
+#ifndef TaskScheduler_h
+#define TaskScheduler_h
+
+#define SCHED_STATS_INTERVAL	(60L)	// Seconds between task reports on the serial log
+
+typedef void (*CSchedulerTask_functionT)();
+
+// One entry in the task table, which is constant
+typedef struct
+{
+	const char *m_name;					// PROGMEM
+	CSchedulerTask_functionT m_function;
+	uint32_t m_period;					// ms
+	uint32_t m_phase;					// ms after start before the first run
+	unsigned int m_catchUp;				// Missed periods to make up, any more are skipped
+	uint32_t m_budget;					// us, a run that takes longer is an overrun
+} CSchedulerTaskT;
+
+// What the scheduler keeps for each task, one per table entry
+typedef struct
+{
+	uint32_t m_nextRun;					// millis() it is due
+	uint32_t m_runs;
+	uint32_t m_lateRuns;				// Runs that started a period or more late
+	uint32_t m_skipped;					// Periods given up on
+	uint32_t m_overruns;				// Runs that took longer than the budget
+	uint32_t m_longestRun;				// us
+	bool m_triggered;					// Run it on the next pass, off schedule
+} CSchedulerTaskStateT;
+
+////////////////////////////////////////////////////////////
+// Each task runs once per its period, offset by its phase so
+// tasks with the same period don't all come due together.
+// Only one task runs per pass through loop(), the first due
+// one in table order, so their worst case run times never
+// stack up on the same pass. Deadlines advance by whole
+// periods, so a late run doesn't push the next one back.
+// When a task misses whole periods it stays due and runs
+// again on the following passes until it has made up at most
+// m_catchUp of them; the rest are skipped and counted.
+//
+// Each run is timed with micros() against the task's budget.
+// Starting late and running long are counted separately: a
+// late start is usually some other task's overrun.
+////////////////////////////////////////////////////////////
+class CTaskScheduler
+{
+protected:
+	const CSchedulerTaskT *m_tasks;
+	CSchedulerTaskStateT *m_states;
+	int m_nTasks;
+
+	uint32_t m_lastSkipped;
+
+	uint32_t m_statsSeconds;
+
+	void runTask(int _index);
+
+public:
+	CTaskScheduler();
+	virtual ~CTaskScheduler();
+
+	// _states needs as many entries as _tasks
+	void start(const CSchedulerTaskT *_tasks, CSchedulerTaskStateT *_states, int _nTasks, uint32_t _now);
+
+	// Call from loop() with its millis(), runs at most one task.
+	// False if none were due.
+	bool runNext(uint32_t _now);
+
+	// Run the task with this function on the next pass, ahead of
+	// anything due. Its schedule isn't changed, it's an extra run.
+	void trigger(CSchedulerTask_functionT _function);
+
+	// For the running task, how many of its periods were
+	// skipped just before this run
+	uint32_t lastSkipped() { return m_lastSkipped; }
+
+	// Periodic late start and overrun report
+	void processOneSecond();
+	void printStats();
+};
+
+#endif
@@ -4,21 +4,28 @@
 #include <Arduino.h>
 #include <math.h>
 
-#include <PID_v1.h>
 
 #include "Pins.h"
 #include "Defs.h"
 #include "MilliTimer.h"
 #include "Settings.h"
+#include "SensorFilter.h"
 #include "TempSensor_Thermocouple.h"
+#include "ThermocoupleBus.h"
+#include "TempSensor_Thermistor.h"
+#include "TempSensorManager.h"
 #include "PWMMotor.h"
 #include "WSPID.h"
+#include "SetpointRamp.h"
+#include "SmithPredictor.h"
+#include "PlantEstimator.h"
+#include "RelayAutotune.h"
 #include "Beeper.h"
 #include "FanController.h"
 #include "ScreenController.h"
 #include "TempController.h"
 
-extern CTempSensor_Thermocouple g_thermocouple;
+extern CTempSensorManager g_tempSensors;
 extern CWoodStoveSettings g_woodStoveSettings;
 extern CPWMMotor g_forcedDraftMotor;
 extern CBeeper g_beeper;
@@ -30,6 +37,14 @@ extern CScreenController g_screenController;
 extern CStoveSim g_stoveSim;
 #endif
 
+#if defined(FLUE_CONTROL_CASCADE) && defined(FLUE_CONTROL_SMITH_PREDICTOR)
+#error Pick one of FLUE_CONTROL_CASCADE and FLUE_CONTROL_SMITH_PREDICTOR
+#endif
+
+#if defined(FLUE_CONTROL_CASCADE) && !defined(PIN_THERMOCOUPLE_CS_FIREBOX) && !defined(SIMULATION_MODE)
+#error FLUE_CONTROL_CASCADE needs a firebox thermocouple (PIN_THERMOCOUPLE_CS_FIREBOX)
+#endif
+
 #define CHANGESTATE(s)	(changeState(__LINE__, s))
 #define TAKEACTION(a)	(takeAction(__LINE__, a))
 
@@ -39,14 +54,41 @@ extern CStoveSim g_stoveSim;
 CTempController::CTempController()
 {
 	m_airBoostButtonPressed = false;
+	m_preBoostSpeed = PWM_MOTOR_STOP;
 	m_currentTemp = 0.;
+	m_controlTemp = 0;
+	m_controlFixed = 0;
 	m_dyingFireLowestTemp = 0.;
 	m_dyingFireAlarmInIdle = false;
 	m_coldStart = false;
 	m_idleSpeedOverride = 0;
-
+	m_lastCallingForHeat = false;
+	m_lastFanOn = false;
+	m_autotuneGains = PID_GAINS_IDLE;
+
+#ifdef FLUE_CONTROL_CASCADE
+	// The flue loop's output is a firebox temperature
+	m_fluePid.SetSampleTime(1000);
+	m_fluePid.SetScale(FLUE_PID_SCALE);
+	m_fluePid.SetOutputLimits(FIREBOX_SETPOINT_MIN, FIREBOX_SETPOINT_MAX);
+	m_fluePid.SetDerivativeFilter(FLUE_PID_D_FILTER_TIME);
+	m_fluePid.SetTrackingTime(FIREBOX_SETPOINT_TRACKING_TIME);
+	m_fluePid.SetMode(MANUAL);
+
+	// The blower PID is the inner loop, it runs at the firebox
+	// probe's rate (the simulator only updates once a second)
+	// and its gains don't change
+#ifdef SIMULATION_MODE
 	m_pid.SetSampleTime(1000);
-	m_pid.SetScale(0.10);
+#else
+	m_pid.SetSampleTime(THERMOCOUPLE_CONVERSION_TIME);
+#endif
+	m_pid.SetTunings(FIREBOX_PID_KP, FIREBOX_PID_KI, FIREBOX_PID_KD);
+	m_pid.SetOutputFilter(FIREBOX_PID_OUTPUT_FILTER_TIME);
+#else
+	m_pid.SetSampleTime(1000);
+	m_pid.SetScale(FLUE_PID_SCALE);
+#endif
 
 	// Set the control limits of the PID. Note: the use of PWM_MOTOR_STOP as the minimum command
 	// *instead of* PWM_MOTOR_MIN_COMMAND is intentional and correct. The PID should be able to
@@ -57,6 +99,20 @@ CTempController::CTempController()
 	// PWM command lower than is needed to keep the motor running.
 	m_pid.SetOutputLimits(PWM_MOTOR_STOP, PWM_MOTOR_MAX_COMMAND);
 
+	// The PID will still ask for speeds below PWM_MOTOR_MIN_COMMAND, but
+	// the blower can't do them. Let the PID know so its integrator
+	// doesn't wind up against them.
+	m_pid.SetDeadZone(PWM_MOTOR_MIN_COMMAND, FLUE_PID_TRACKING_TIME);
+
+	// A one degree tick in one second is a big kick with the D gains
+	// we run, so smooth the derivative over several samples
+	m_pid.SetDerivativeFilter(FLUE_PID_D_FILTER_TIME);
+	m_pid.SetFeedforwardDecay(FLUE_FF_DECAY_TIME);
+
+#ifdef FLUE_CONTROL_SMITH_PREDICTOR
+	m_smithPredictor.setModel(FLUE_MODEL_GAIN, FLUE_MODEL_TIME_CONSTANT, FLUE_MODEL_DEAD_TIME);
+#endif
+
 	m_state = state_noFire;
 	m_pid.SetMode(MANUAL);
 	m_pid.SetOutput(PWM_MOTOR_STOP);
@@ -90,6 +146,11 @@ void CTempController::setup()
 	pinMode(PIN_FD_BLAST_C, OUTPUT);
 	digitalWrite(PIN_FD_BLAST_C, LOW);
 
+#ifdef FLUE_CONTROL_CASCADE
+	// The inner loop is only as fast as its probe
+	g_tempSensors.setReadPeriod(TEMP_SENSOR_FIREBOX, THERMOCOUPLE_CONVERSION_TIME);
+#endif
+
 	updateSettings();
 }
 
@@ -98,19 +159,79 @@ void CTempController::setup()
 // mute/blast buttons
 void CTempController::processFast()
 {
-	m_currentTemp = g_thermocouple.temperature();
+	m_currentTemp = g_tempSensors.temperature(TEMP_SENSOR_FLUE);
+
+	// On a cold morning the same fire gives a cooler flue, so if we
+	// know the ambient temperature, control on the flue-minus-ambient
+	// delta (shifted back to AMBIENT_REFERENCE_TEMP so the setpoints
+	// still read as flue temperatures)
+	long controlFixed = g_tempSensors.temperatureFixed(TEMP_SENSOR_FLUE);
+	long ambientFixed = g_tempSensors.ambientTemperatureFixed();
+	if((controlFixed != THERMOCOUPLE_INVALID_FIXED) && (ambientFixed != THERMOCOUPLE_INVALID_FIXED))
+		controlFixed -= ambientFixed - THERMOCOUPLE_TO_FIXED(AMBIENT_REFERENCE_TEMP);
+
+	if(m_currentTemp == THERMOCOUPLE_INVALID_TEMP)
+		m_controlTemp = THERMOCOUPLE_INVALID_TEMP;
+	else
+		m_controlTemp = THERMOCOUPLE_FROM_FIXED(controlFixed);
+	m_controlFixed = controlFixed;
+
+	// Don't integrate while the PID isn't in charge of the blower:
+	// the startup kick, or the manual idle speed
+	bool overridden = (m_state == state_idle) && (m_idleSpeedOverride > 0);
+	m_pid.FreezeIntegrator(overridden || g_forcedDraftMotor.isStarting());
+
+	unsigned long sequence = g_tempSensors.getSampleSequence(TEMP_SENSOR_FLUE);
+	unsigned long sampleTime = g_tempSensors.getSampleTime(TEMP_SENSOR_FLUE);
+
+#ifdef FLUE_CONTROL_CASCADE
+	// The flue loop follows the blower PID out of AUTOMATIC (startPID()
+	// brings it back). It is run either way so it is tracking the flue
+	// when it takes over.
+	if(m_pid.GetMode() == MANUAL)
+		m_fluePid.SetMode(MANUAL);
+	m_fluePid.FreezeIntegrator(overridden || g_forcedDraftMotor.isStarting());
+
+	// With the blower pinned at either end the firebox can't go where
+	// the flue loop asks, so the flue loop's integrator tracks the
+	// firebox temperature it is getting instead of winding up
+	int blower = m_pid.GetOutput();
+	int firebox = g_tempSensors.temperature(TEMP_SENSOR_FIREBOX);
+	if(((blower <= PWM_MOTOR_STOP) || (blower >= PWM_MOTOR_MAX_COMMAND)) && (firebox != THERMOCOUPLE_INVALID_TEMP))
+		m_fluePid.TrackOutput(firebox);
+	else
+		m_fluePid.StopTracking();
+
+	int fireboxSetpoint = m_fluePid.Compute(controlFixed, sequence, sampleTime);
+	if(m_fluePid.GetMode() == AUTOMATIC)
+		m_pid.SetSetpoint(fireboxSetpoint);
+
+	// From here on the blower PID works on the firebox
+	controlFixed = g_tempSensors.temperatureFixed(TEMP_SENSOR_FIREBOX);
+	sequence = g_tempSensors.getSampleSequence(TEMP_SENSOR_FIREBOX);
+	sampleTime = g_tempSensors.getSampleTime(TEMP_SENSOR_FIREBOX);
+#endif
+
+#ifdef FLUE_CONTROL_SMITH_PREDICTOR
+	// The model follows whatever the blower was really doing, PID
+	// or not, so the prediction is right when the PID takes over
+	long prediction = m_smithPredictor.process(sequence, sampleTime, g_forcedDraftMotor.getSpeed());
+	if(m_currentTemp != THERMOCOUPLE_INVALID_TEMP)
+		controlFixed += prediction;
+#endif
 
-	// Send it to the PWM
-	double pidOutput = m_pid.Compute(m_currentTemp);
+	// Send it to the PWM. The PID gets the full resolution
+	// reading, and only runs when the sensor has a new sample.
+	int pidOutput = m_pid.Compute(controlFixed, sequence, sampleTime);
 
 	// During the initial PID setup, when kI & kD are probably
 	// zero, it is helpful to get the forced draft blower running
 	// without PID control so that the stove will idle.
-	if( (m_state == state_idle) && (m_idleSpeedOverride > 0) )
+	if(overridden)
 		pidOutput = m_idleSpeedOverride;
 
 	// Set the speed computed by the PID
-	g_forcedDraftMotor.setSpeed((int)roundf(pidOutput));
+	g_forcedDraftMotor.setSpeed(pidOutput);
 
 	// Check for the alarm mute button
 	if(digitalRead(PIN_MUTE_ALARM) == 0)
@@ -166,8 +287,15 @@ void CTempController::processOneSecond()
 	Serial.print(g_forcedDraftMotor.getSpeed());
 	Serial.print(F(", "));
 
+#ifdef PIN_AMBIENT_THERMISTOR
+	Serial.print(g_fanController.isFanOn());
+	Serial.print(F(", "));
+
+	Serial.println(g_tempSensors.ambientTemperature());
+#else
 	Serial.println(g_fanController.isFanOn());
 #endif
+#endif
 
 #ifdef SERIAL_PLOT
 	Serial.print(callingForHeat() ? 10 : 0);	// The "10" just makes it visible on the plot
@@ -192,6 +320,11 @@ void CTempController::processOneSecond()
 	Serial.println();
 #endif
 
+	// Don't run the state machine until the sensor
+	// has delivered its first reading
+	if(g_tempSensors.isWarming(TEMP_SENSOR_FLUE))
+		return;
+
 	// Alarm is handled in a special way
 	if( (temperatureAlarm() != alarm_none) &&
 		(m_state != state_alarm) )
@@ -215,6 +348,20 @@ void CTempController::processOneSecond()
 		TAKEACTION(action_stopFuelWaitAlarm);
 	}
 
+#ifdef PLANT_ESTIMATOR
+	// Learn the stove from what the PID does with it. Anything else
+	// driving the blower breaks the history.
+	bool overridden = (m_state == state_idle) && (m_idleSpeedOverride > 0);
+	if((m_pid.GetMode() == AUTOMATIC) && !overridden && (m_controlTemp != THERMOCOUPLE_INVALID_TEMP))
+		m_plantEstimator.processOneSecond(m_controlFixed, g_forcedDraftMotor.getSpeed());
+	else
+		m_plantEstimator.restart();
+#endif
+
+	// Walk the PID's setpoint toward the target
+	if(flueLoop().GetMode() == AUTOMATIC)
+		flueLoop().SetSetpointFixed(m_setpointRamp.processOneSecond());
+
 	// Run the state machine
 	switch(m_state)
 	{
@@ -248,7 +395,7 @@ void CTempController::processOneSecond()
 		// Air boost works in noFire
 		if(m_airBoostButtonPressed)
 		{
-			if(m_currentTemp < g_settings.m_targetRunTemp - TEMP_DYING_FIRE_OFFSET)
+			if(m_controlTemp < g_settings.m_targetRunTemp - TEMP_DYING_FIRE_OFFSET)
 			{
 #ifdef DEBUG_TEMP_CONTROLLER
 				printUptime();
@@ -320,7 +467,7 @@ void CTempController::processOneSecond()
 		// Is the fire dying in idle mode?
 		// If the flue is too cold then set the flue-temperature wait timer.
 		// We are watching for the fire to die out while running.
-		if(m_currentTemp < (g_settings.m_targetIdleTemp - TEMP_DYING_FIRE_OFFSET) )
+		if(m_controlTemp < (g_settings.m_targetIdleTemp - TEMP_DYING_FIRE_OFFSET) )
 		{
 			if(m_flueTempTimer.getState() == CMilliTimer::notSet)
 			{
@@ -345,7 +492,7 @@ void CTempController::processOneSecond()
 		// is below the run temp
 		if(m_airBoostButtonPressed)
 		{
-			if(m_currentTemp < (g_settings.m_targetRunTemp - TEMP_DYING_FIRE_OFFSET))
+			if(m_controlTemp < (g_settings.m_targetRunTemp - TEMP_DYING_FIRE_OFFSET))
 			{
 #ifdef DEBUG_TEMP_CONTROLLER
 				printUptime();
@@ -397,7 +544,7 @@ void CTempController::processOneSecond()
 #endif
 			m_flueTempTimer.reset();
 
-			m_dyingFireLowestTemp = m_currentTemp;
+			m_dyingFireLowestTemp = m_controlTemp;
 
 			TAKEACTION(action_startFuelWaitAlarm);
 			TAKEACTION(action_forcedDraftOff);
@@ -406,8 +553,9 @@ void CTempController::processOneSecond()
 		}
 
 		// If the flue is too cold then set the flue-temperature wait timer.
-		// We are watching for the fire to die out while running.
-		if(m_currentTemp < (g_settings.m_targetRunTemp - TEMP_DYING_FIRE_OFFSET))
+		// We are watching for the fire to die out while running. While the
+		// setpoint is still ramping up, the flue only has to keep up with it.
+		if(m_controlTemp < (rampedTargetTemp() - TEMP_DYING_FIRE_OFFSET))
 		{
 				// If this is a cold start then assume that it could take a lot
 				// longer to reach operating temperature
@@ -432,14 +580,14 @@ void CTempController::processOneSecond()
 	// up,or for the fire to die completely
 	case state_dyingFire:
 
-		if(m_currentTemp < m_dyingFireLowestTemp)
-			m_dyingFireLowestTemp = m_currentTemp;
+		if(m_controlTemp < m_dyingFireLowestTemp)
+			m_dyingFireLowestTemp = m_controlTemp;
 
 		// If the flue warms up well above the lowest noted temperature then
 		// they must has added fuel, so head for idle (and then running?)
 		// Or, if the temp goes so low that the forced draft will not activate
 		// then go to idle, and probably stay there.
-		if(m_currentTemp > (m_dyingFireLowestTemp + TEMP_DYING_FIRE_OFFSET))
+		if(m_controlTemp > (m_dyingFireLowestTemp + TEMP_DYING_FIRE_OFFSET))
 		{
 #ifdef DEBUG_TEMP_CONTROLLER
 			printUptime();
@@ -470,7 +618,7 @@ void CTempController::processOneSecond()
 		// Air boost always works in dying_fire
 		if(m_airBoostButtonPressed)
 		{
-			if(m_currentTemp < (g_settings.m_targetRunTemp - TEMP_DYING_FIRE_OFFSET))
+			if(m_controlTemp < (g_settings.m_targetRunTemp - TEMP_DYING_FIRE_OFFSET))
 			{
 #ifdef DEBUG_TEMP_CONTROLLER
 				printUptime();
@@ -505,6 +653,72 @@ void CTempController::processOneSecond()
 
 		break;	// case state_alarm:
 
+	// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+	// Autotune - the relay drives the blower until it has measured
+	// the stove, then we go back to where we started with the
+	// results in hand
+	case state_autotune:
+
+		// The house comes first, if the thermostat changes its mind
+		// then the run is over
+		if(callingForHeat() != (m_autotuneGains == PID_GAINS_RUN))
+		{
+#ifdef DEBUG_TEMP_CONTROLLER
+			printUptime();
+			printState(m_state, false);
+			Serial.println(F("CTempController::processOneSecond() - thermostat changed - autotune cancelled"));
+#endif
+			m_autotune.cancel();
+			if(callingForHeat())
+			{
+				TAKEACTION(action_forcedDraftRun);
+				CHANGESTATE(state_running);
+			}
+			else
+			{
+				TAKEACTION(action_forcedDraftIdle);
+				CHANGESTATE(state_idle);
+			}
+			break;
+		}
+
+		if(m_currentTemp < MIN_FORCED_DRAFT_TEMP)
+		{
+#ifdef DEBUG_TEMP_CONTROLLER
+			printUptime();
+			printState(m_state, false);
+			Serial.println(F("CTempController::processOneSecond() - flue too cool - autotune cancelled"));
+#endif
+			m_autotune.cancel();
+			TAKEACTION(action_forcedDraftOff);
+			CHANGESTATE(state_noFire);
+			break;
+		}
+
+		m_pid.SetOutput(m_autotune.processOneSecond(m_controlTemp));
+
+		if(m_autotune.getState() != CRelayAutotune::state_running)
+		{
+#ifdef DEBUG_TEMP_CONTROLLER
+			printUptime();
+			printState(m_state, false);
+			Serial.println(F("CTempController::processOneSecond() - autotune finished"));
+#endif
+			if(m_autotuneGains == PID_GAINS_RUN)
+			{
+				TAKEACTION(action_forcedDraftRun);
+				CHANGESTATE(state_running);
+			}
+			else
+			{
+				TAKEACTION(action_forcedDraftIdle);
+				CHANGESTATE(state_idle);
+			}
+			break;
+		}
+
+		break;	// case state_autotune:
+
 	// =-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 	// Air boost - feed air to the fire or a while, or
 	// until the fire gets hot enough
@@ -525,7 +739,7 @@ void CTempController::processOneSecond()
 		}
 
 		// Or temperature
-		if(m_currentTemp >= g_settings.m_targetIdleTemp)
+		if(m_controlTemp >= g_settings.m_targetIdleTemp)
 		{
 #ifdef DEBUG_TEMP_CONTROLLER
 		printUptime();
@@ -539,14 +753,95 @@ void CTempController::processOneSecond()
 		{
 
 			m_airBoostTimer.reset();
-			TAKEACTION(action_forcedDraftOff);	// Dump the integrator
-			TAKEACTION(action_forcedDraftIdle);
+			TAKEACTION(action_forcedDraftResume);
 			CHANGESTATE(state_idle);
 			break;
 		}
 
 		break;	// case state_airBoost:
 	}
+
+	// After the state machine, so a call for heat has
+	// already put the PID on the run setpoint
+	feedforward();
+}
+
+////////////////////////////////////////////////////////////
+// The flue takes ~30 seconds to show a change at the fire, but
+// some changes we see coming. Give the blower a head start.
+void CTempController::feedforward()
+{
+	bool heat = callingForHeat();
+	bool fan = g_fanController.isFanOn();
+
+	if(heat && !m_lastCallingForHeat)
+		m_pid.AddFeedforward(FLUE_FF_CALL_FOR_HEAT);
+
+	if(fan != m_lastFanOn)
+		m_pid.AddFeedforward(fan ? FLUE_FF_FAN_ON : -FLUE_FF_FAN_ON);
+
+	m_lastCallingForHeat = heat;
+	m_lastFanOn = fan;
+}
+
+////////////////////////////////////////////////////////////
+// Relay autotune
+bool CTempController::startAutotune()
+{
+#ifdef FLUE_CONTROL_CASCADE
+	// The relay measures flue against blower, which isn't
+	// either of the cascade's loops
+	return false;
+#endif
+
+	if(m_state == state_idle)
+		m_autotuneGains = PID_GAINS_IDLE;
+	else if(m_state == state_running)
+		m_autotuneGains = PID_GAINS_RUN;
+	else
+		return false;
+
+	TAKEACTION(action_startAutotune);
+	CHANGESTATE(state_autotune);
+	return true;
+}
+
+void CTempController::cancelAutotune()
+{
+	bool wasRunning = (m_state == state_autotune);
+
+	m_autotune.cancel();
+
+	if(wasRunning)
+	{
+		if(m_autotuneGains == PID_GAINS_RUN)
+		{
+			TAKEACTION(action_forcedDraftRun);
+			CHANGESTATE(state_running);
+		}
+		else
+		{
+			TAKEACTION(action_forcedDraftIdle);
+			CHANGESTATE(state_idle);
+		}
+	}
+}
+
+void CTempController::acceptAutotune()
+{
+	if(m_autotune.getState() != CRelayAutotune::state_done)
+		return;
+
+	// The autotuner works in real PWM counts per degree, the
+	// settings hold gains before the PID's scale is applied
+	g_settings.m_Kp[m_autotuneGains] = m_autotune.getKp() / FLUE_PID_SCALE;
+	g_settings.m_Ki[m_autotuneGains] = m_autotune.getKi() / FLUE_PID_SCALE;
+	g_settings.m_Kd[m_autotuneGains] = m_autotune.getKd() / FLUE_PID_SCALE;
+
+	// Saved after the PID has had a look, in case it clamped them
+	m_autotune.cancel();
+	updateSettings();
+	g_settings.saveSettings();
 }
 
 ////////////////////////////////////////////////////////////
@@ -559,18 +854,95 @@ void CTempController::updateSettings()
 	Serial.println(F("CTempController::updateSettings() - loading settings"));
 #endif
 
-	if( (m_pid.GetKp() != g_settings.m_Kp) ||
-		(m_pid.GetKi() != g_settings.m_Ki) ||
-		(m_pid.GetKd() != g_settings.m_Kd) )
-	{
-		m_pid.SetTunings(g_settings.m_Kp, g_settings.m_Ki, g_settings.m_Kd);
-	}
+	selectGains((m_state == state_running) ? PID_GAINS_RUN : PID_GAINS_IDLE);
 
 	if(m_state == state_idle)
-		m_pid.SetSetpoint(g_settings.m_targetIdleTemp);
+		rampSetpoint(g_settings.m_targetIdleTemp);
 
 	if(m_state == state_running)
-		m_pid.SetSetpoint(g_settings.m_targetRunTemp);
+		rampSetpoint(g_settings.m_targetRunTemp);
+}
+
+////////////////////////////////////////////////////////////
+// Load one set of gains into the PID. This is bumpless,
+// so it can be done on the fly when the state changes.
+void CTempController::selectGains(int _gainSet)
+{
+	CWSPID &pid = flueLoop();
+
+	if( (pid.GetKp() != g_settings.m_Kp[_gainSet]) ||
+		(pid.GetKi() != g_settings.m_Ki[_gainSet]) ||
+		(pid.GetKd() != g_settings.m_Kd[_gainSet]) )
+	{
+		// Gains the PID can't hold are clamped, put what it really
+		// uses back in the settings so the setup screen shows it
+		if(!pid.SetTunings(g_settings.m_Kp[_gainSet], g_settings.m_Ki[_gainSet], g_settings.m_Kd[_gainSet]))
+		{
+#ifdef DEBUG_TEMP_CONTROLLER
+			printUptime();
+			Serial.println(F("CTempController::selectGains() - gains clamped"));
+#endif
+			g_settings.m_Kp[_gainSet] = pid.GetKp();
+			g_settings.m_Ki[_gainSet] = pid.GetKi();
+			g_settings.m_Kd[_gainSet] = pid.GetKd();
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////
+// Put the PID in charge of the blower, continuing from _seed so
+// the blower doesn't jump when we change states
+void CTempController::startPID(int _gainSet, int _setpoint, int _seed)
+{
+#ifdef FLUE_CONTROL_CASCADE
+	// The flue loop starts out asking for the firebox temp we have
+	if(m_fluePid.GetMode() == MANUAL)
+	{
+		int firebox = g_tempSensors.temperature(TEMP_SENSOR_FIREBOX);
+		m_fluePid.SetOutput(firebox);
+		m_fluePid.SetMode(AUTOMATIC);
+		m_pid.SetSetpoint(firebox);
+	}
+#endif
+
+	m_pid.SetMode(AUTOMATIC);
+	rampSetpoint(_setpoint);
+	m_pid.PreloadIntegrator(_seed);
+	selectGains(_gainSet);
+}
+
+////////////////////////////////////////////////////////////
+// Move the PID toward a new setpoint. Going up it ramps from
+// wherever the flue is now (or from where the last ramp got
+// to, if that is higher), going down it steps.
+void CTempController::rampSetpoint(int _setpoint)
+{
+	int32_t target = THERMOCOUPLE_TO_FIXED(_setpoint);
+	int32_t from = m_setpointRamp.getSetpoint();
+
+	if(m_controlTemp != THERMOCOUPLE_INVALID_TEMP)
+		from = max(from, THERMOCOUPLE_TO_FIXED(m_controlTemp));
+
+	if(from < target)
+	{
+#ifdef SETPOINT_RAMP_S_CURVE
+		m_setpointRamp.start(from, target, SETPOINT_RAMP_RATE, true);
+#else
+		m_setpointRamp.start(from, target, SETPOINT_RAMP_RATE, false);
+#endif
+	}
+	else
+	{
+		m_setpointRamp.jumpTo(target);
+	}
+
+	flueLoop().SetSetpointFixed(m_setpointRamp.getSetpoint());
+}
+
+// Where the setpoint ramp is now, in whole degrees
+int CTempController::rampedTargetTemp()
+{
+	return THERMOCOUPLE_FROM_FIXED(m_setpointRamp.getSetpoint());
 }
 
 bool CTempController::callingForHeat()
@@ -593,6 +965,9 @@ int CTempController::getTargetTemp()
 	if(m_state == state_running)
 		return g_settings.m_targetRunTemp;
 
+	if(m_state == state_autotune)
+		return (m_autotuneGains == PID_GAINS_RUN) ? g_settings.m_targetRunTemp : g_settings.m_targetIdleTemp;
+
 	return THERMOCOUPLE_INVALID_TEMP;
 }
 
@@ -627,11 +1002,13 @@ void CTempController::takeAction(int _lineNo, CTempController_actionE _action)
 				   (_action == action_forcedDraftIdle) ? F("action_forcedDraftIdle") :
 				   (_action == action_forcedDraftRun) ? F("action_forcedDraftRun") :
 				   (_action == action_forcedDraftFull) ? F("action_forcedDraftFull") :
+				   (_action == action_forcedDraftResume) ? F("action_forcedDraftResume") :
 				   (_action == action_startAirBoostTimer) ? F("action_startAirBoostTimer") :
 				   (_action == action_startFuelWaitAlarm) ? F("action_startFuelWaitAlarm") :
 				   (_action == action_stopFuelWaitAlarm) ? F("action_stopFuelWaitAlarm") :
 				   (_action == action_alarmConditionOn) ? F("action_alarmConditionOn") :
 				   (_action == action_alarmConditionOff) ? F("action_alarmConditionOff") :
+				   (_action == action_startAutotune) ? F("action_startAutotune") :
 				   (F("*** ERROR UNKNOWN ***")));
 #else
 	UNUSED(_lineNo);
@@ -650,20 +1027,25 @@ void CTempController::takeAction(int _lineNo, CTempController_actionE _action)
 		break;
 
 	case action_forcedDraftIdle:
-		m_pid.SetMode(AUTOMATIC);
-		m_pid.SetSetpoint(g_settings.m_targetIdleTemp);
+		startPID(PID_GAINS_IDLE, g_settings.m_targetIdleTemp, g_forcedDraftMotor.getSpeed());
 		break;
 
 	case action_forcedDraftRun:
-		m_pid.SetMode(AUTOMATIC);
-		m_pid.SetSetpoint(g_settings.m_targetRunTemp);
+		startPID(PID_GAINS_RUN, g_settings.m_targetRunTemp, g_forcedDraftMotor.getSpeed());
 		break;
 
 	case action_forcedDraftFull:
+		m_preBoostSpeed = g_forcedDraftMotor.getSpeed();
 		m_pid.SetMode(MANUAL);
 		m_pid.SetOutput(PWM_MOTOR_MAX_COMMAND);
 		break;
 
+	// Back to idle after an air boost. The boost speed says nothing
+	// about what the fire needs, so pick up where we were before it.
+	case action_forcedDraftResume:
+		startPID(PID_GAINS_IDLE, g_settings.m_targetIdleTemp, m_preBoostSpeed);
+		break;
+
 	case action_startAirBoostTimer:
 		if(m_airBoostTimer.getState() == CMilliTimer::notSet)
 			m_airBoostTimer.start(DEF_FORCED_DRAFT_BOOST_TIME * ONE_SECOND_MS);
@@ -680,6 +1062,8 @@ void CTempController::takeAction(int _lineNo, CTempController_actionE _action)
 		break;
 
 	case action_alarmConditionOn:
+		if(m_autotune.getState() == CRelayAutotune::state_running)
+			m_autotune.cancel();
 		m_pid.SetMode(MANUAL);
 		m_pid.SetOutput(PWM_MOTOR_STOP);
 		g_fanController.forceFanOn(true);
@@ -690,15 +1074,31 @@ void CTempController::takeAction(int _lineNo, CTempController_actionE _action)
 		g_beeper.beep(0, 0);
 		g_fanController.forceFanOn(false);
 		break;
+
+	case action_startAutotune:
+		m_autotune.start((m_autotuneGains == PID_GAINS_RUN) ? g_settings.m_targetRunTemp : g_settings.m_targetIdleTemp, g_forcedDraftMotor.getSpeed());
+		m_pid.SetMode(MANUAL);
+		m_pid.SetOutput(m_autotune.getOutput());
+		break;
 	}
 }
 
 CTempController::CTempController_alarmE CTempController::temperatureAlarm()
 {
+	// A sensor that is still warming up is not a bad probe
+	if(g_tempSensors.isWarming(TEMP_SENSOR_FLUE))
+		return alarm_none;
+
 	// Make sure the thermocouple is ok
 	if(m_currentTemp == THERMOCOUPLE_INVALID_TEMP)
 		return alarm_badProbe;
 
+#ifdef FLUE_CONTROL_CASCADE
+	// The blower can't be run without the firebox probe either
+	if(g_tempSensors.temperature(TEMP_SENSOR_FIREBOX) == THERMOCOUPLE_INVALID_TEMP)
+		return alarm_badProbe;
+#endif
+
 	// And the flue temp is not too high
 	if(m_currentTemp >= g_settings.m_alarmFlueTemp)
 		return alarm_overTemp;
@@ -714,6 +1114,7 @@ void CTempController::printState(CTempController_stateE _state, bool _lf)
 				 (_state == state_dyingFire) ? F("state_dyingFire") :
 				 (_state == state_alarm) ? F("state_alarm") :
 				 (_state == state_airBoost) ? F("state_airBoost") :
+				 (_state == state_autotune) ? F("state_autotune") :
 				 (F("*** ERROR UNKNOWN ***")));
 	if(_lf)
 		Serial.println();
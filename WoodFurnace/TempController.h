@@ -27,6 +27,7 @@ public:
 		state_dyingFire,
 		state_alarm,
 		state_airBoost,
+		state_autotune,
 	} CTempController_stateE;
 
 protected:
@@ -39,6 +40,7 @@ protected:
 		action_forcedDraftIdle,
 		action_forcedDraftRun,
 		action_forcedDraftFull,
+		action_forcedDraftResume,
 
 		action_startAirBoostTimer,
 
@@ -48,11 +50,15 @@ protected:
 		action_alarmConditionOn,
 		action_alarmConditionOff,
 
+		action_startAutotune,
+
 	} CTempController_actionE;
 
 	CTempController_stateE m_state;
 
-	int m_currentTemp;
+	int m_currentTemp;		// Flue temp as read, for alarms and logging
+	int m_controlTemp;		// Flue temp corrected for ambient, for control
+	long m_controlFixed;	// The same, full resolution (Q8)
 	CMilliTimer m_flueTempTimer;
 
 	int m_dyingFireLowestTemp;
@@ -60,13 +66,43 @@ protected:
 
 	bool m_airBoostButtonPressed;
 	CMilliTimer m_airBoostTimer;
+	int m_preBoostSpeed;	// Blower speed before the boost, to pick up from after
 
 	bool m_dyingFireAlarmInIdle;
 	bool m_coldStart;
 
 	int m_idleSpeedOverride;
 
-	CWSPID m_pid;
+	// Last seen, for feedforward on the changes
+	bool m_lastCallingForHeat;
+	bool m_lastFanOn;
+
+	CWSPID m_pid;			// Drives the blower
+#ifdef FLUE_CONTROL_CASCADE
+	CWSPID m_fluePid;		// Outer loop, flue -> firebox setpoint for m_pid
+#endif
+	CSetpointRamp m_setpointRamp;
+#ifdef FLUE_CONTROL_SMITH_PREDICTOR
+	CSmithPredictor m_smithPredictor;
+#endif
+#ifdef PLANT_ESTIMATOR
+	CPlantEstimator m_plantEstimator;
+#endif
+	CRelayAutotune m_autotune;
+	int m_autotuneGains;	// PID_GAINS_xxx the autotune run is for
+
+	// The PID that holds the flue setpoint and the gains from the settings
+#ifdef FLUE_CONTROL_CASCADE
+	CWSPID &flueLoop() { return m_fluePid; }
+#else
+	CWSPID &flueLoop() { return m_pid; }
+#endif
+
+	void selectGains(int _gainSet);
+	void startPID(int _gainSet, int _setpoint, int _seed);
+	void rampSetpoint(int _setpoint);
+	int rampedTargetTemp();
+	void feedforward();
 
 	void changeState(int _lineNo, CTempController_stateE _newState);
 	void takeAction(int _lineNo, CTempController_actionE _action);
@@ -99,6 +135,20 @@ public:
 	{
 		m_idleSpeedOverride = _s;
 	}
+
+	// Relay autotune. It can be started from idle or running and tunes
+	// that state's gains. The results wait on the PID setup screen
+	// to be accepted or rejected.
+	bool startAutotune();
+	void cancelAutotune();
+	void acceptAutotune();
+	CRelayAutotune &getAutotune() { return m_autotune; }
+
+#ifdef PLANT_ESTIMATOR
+	// Dead time, time constant and gain of the stove, learned
+	// while the PID is driving the blower
+	CPlantEstimator &getPlantEstimator() { return m_plantEstimator; }
+#endif
 };
 
 #endif
@@ -0,0 +1,289 @@
+////////////////////////////////////////////////////
+// Owns all of the thermocouples on the shared bus
+////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Pins.h"
+#include "Defs.h"
+
+#ifdef SIMULATION_MODE
+#include "StoveSim.h"
+extern CStoveSim g_stoveSim;
+#endif
+#include "SensorFilter.h"
+#include "TempSensor_Thermocouple.h"
+#include "ThermocoupleBus.h"
+#include "TempSensor_Thermistor.h"
+#include "TempSensorManager.h"
+
+// =================================================
+// 'structors
+// =================================================
+CTempSensorManager::CTempSensorManager()
+{
+	for(int _ = 0; _ < TEMP_SENSOR_COUNT; ++_)
+	{
+		m_installed[_] = false;
+		m_readPeriod[_] = THERMOCOUPLE_READ_PERIOD;
+		m_lastReadTime[_] = 0;
+	}
+	m_nInstalled = 0;
+
+	m_nextChannel = 0;
+	m_initMillis = 0;
+	m_lastSlotTime = 0;
+	m_slotTime = THERMOCOUPLE_READ_PERIOD;
+	m_warmedUp = false;
+
+	m_statsSeconds = 0;
+
+#ifdef PIN_AMBIENT_THERMISTOR
+	m_lastAmbientTime = 0;
+#endif
+}
+
+CTempSensorManager::~CTempSensorManager()
+{
+}
+
+// =================================================
+// Prepare for operation
+// =================================================
+void CTempSensorManager::init()
+{
+#ifdef DEBUG_TEMPSENSOR
+	Serial.println(F("CTempSensorManager::init()"));
+#endif
+
+	// The shared bus
+	m_bus.init();
+
+	// Now the individual chips
+	addChannel(TEMP_SENSOR_FLUE, PIN_THERMOCOUPLE_CS_FLUE);
+#ifdef PIN_THERMOCOUPLE_CS_FIREBOX
+	addChannel(TEMP_SENSOR_FIREBOX, PIN_THERMOCOUPLE_CS_FIREBOX);
+#endif
+#ifdef PIN_THERMOCOUPLE_CS_PLENUM
+	addChannel(TEMP_SENSOR_PLENUM, PIN_THERMOCOUPLE_CS_PLENUM);
+#endif
+
+#ifdef PIN_AMBIENT_THERMISTOR
+	m_ambient.init(PIN_AMBIENT_THERMISTOR);
+#endif
+
+	// The chips all powered up together, so they all
+	// finish their first conversion at the same time
+	m_initMillis = millis();
+	m_warmedUp = false;
+}
+
+void CTempSensorManager::addChannel(int _channel, int _csPin)
+{
+	m_sensors[_channel].init(_csPin);
+	m_installed[_channel] = true;
+	m_nInstalled++;
+
+	updateSlotTime();
+}
+
+void CTempSensorManager::setReadPeriod(int _channel, uint32_t _period)
+{
+	if((_channel < 0) || (_channel >= TEMP_SENSOR_COUNT))
+		return;
+
+	m_readPeriod[_channel] = max(_period, (uint32_t)THERMOCOUPLE_CONVERSION_TIME);
+	updateSlotTime();
+}
+
+// Enough slots that the fastest channel can be read on time even
+// when every other channel is due in between. Rounded up, so a
+// full round of slots is never shorter than a read period.
+void CTempSensorManager::updateSlotTime()
+{
+	uint32_t fastest = THERMOCOUPLE_READ_PERIOD;
+
+	for(int _ = 0; _ < TEMP_SENSOR_COUNT; ++_)
+	{
+		if(m_installed[_])
+			fastest = min(fastest, m_readPeriod[_]);
+	}
+
+	int n = max(m_nInstalled, 1);
+	m_slotTime = (fastest + n - 1) / n;
+}
+
+// =================================================
+// Operate
+// =================================================
+void CTempSensorManager::processFast()
+{
+	if(m_nInstalled == 0)
+		return;
+
+	uint32_t now = millis();
+
+	// Don't touch the bus until the first conversions are done
+	if(!m_warmedUp)
+	{
+		if((now - m_initMillis) < THERMOCOUPLE_WARMUP_TIME)
+			return;
+
+		m_warmedUp = true;
+		m_lastSlotTime = now - m_slotTime;
+		for(int _ = 0; _ < TEMP_SENSOR_COUNT; ++_)
+			m_lastReadTime[_] = now - m_readPeriod[_];
+	}
+
+	// Like CMilliTimer, compare elapsed time rather than deadlines
+	// so the schedule survives millis() rolling over.
+	if((now - m_lastSlotTime) < m_slotTime)
+	{
+		// The ambient sensor fills in on a pass with no SPI traffic
+#ifdef PIN_AMBIENT_THERMISTOR
+		if((now - m_lastAmbientTime) >= THERMISTOR_READ_PERIOD)
+		{
+			m_lastAmbientTime = now;
+			m_ambient.updateTemp();
+		}
+#endif
+		return;
+	}
+	m_lastSlotTime = now;
+
+	// Read the next installed channel that is due. The read time is
+	// when it actually happened, a late read must not bring the next
+	// one closer than the chip's conversion time.
+	for(int _ = 0; _ < TEMP_SENSOR_COUNT; ++_)
+	{
+		int channel = m_nextChannel;
+		m_nextChannel = (m_nextChannel + 1) % TEMP_SENSOR_COUNT;
+
+		if(m_installed[channel] && ((now - m_lastReadTime[channel]) >= m_readPeriod[channel]))
+		{
+			m_lastReadTime[channel] = now;
+			m_sensors[channel].updateTemp(m_bus);
+			return;
+		}
+	}
+}
+
+void CTempSensorManager::processOneSecond()
+{
+	// Periodic health report so flaky wiring shows up
+	// in the log before it trips the furnace
+	if(++m_statsSeconds < THERMOCOUPLE_STATS_INTERVAL)
+		return;
+	m_statsSeconds = 0;
+
+#ifdef SERIAL_LOG
+	for(int _ = 0; _ < TEMP_SENSOR_COUNT; ++_)
+	{
+		if(!m_installed[_])
+			continue;
+
+		// PROBE, uptime, channel, good, open, jump, longest streak
+		Serial.print(F("PROBE, "));
+		printUptime(false);
+		Serial.print(F(", "));
+		Serial.print(_);
+		Serial.print(F(", "));
+		m_sensors[_].printStats();
+		Serial.println();
+	}
+#endif
+}
+
+bool CTempSensorManager::isInstalled(int _channel)
+{
+	if((_channel < 0) || (_channel >= TEMP_SENSOR_COUNT))
+		return false;
+
+	return m_installed[_channel];
+}
+
+int CTempSensorManager::temperature(int _channel)
+{
+#ifdef SIMULATION_MODE
+	if(_channel == TEMP_SENSOR_FLUE)
+		return g_stoveSim.getTemperature();
+	if(_channel == TEMP_SENSOR_FIREBOX)
+		return g_stoveSim.getFireboxTemperature();
+#endif
+
+	if(!isInstalled(_channel))
+		return THERMOCOUPLE_INVALID_TEMP;
+
+	return m_sensors[_channel].temperature();
+}
+
+int32_t CTempSensorManager::temperatureFixed(int _channel)
+{
+#ifdef SIMULATION_MODE
+	if(_channel == TEMP_SENSOR_FLUE)
+		return THERMOCOUPLE_TO_FIXED(g_stoveSim.getTemperature());
+	if(_channel == TEMP_SENSOR_FIREBOX)
+		return THERMOCOUPLE_TO_FIXED(g_stoveSim.getFireboxTemperature());
+#endif
+
+	if(!isInstalled(_channel))
+		return THERMOCOUPLE_INVALID_FIXED;
+
+	return m_sensors[_channel].temperatureFixed();
+}
+
+uint32_t CTempSensorManager::getSampleTime(int _channel)
+{
+#ifdef SIMULATION_MODE
+	if((_channel == TEMP_SENSOR_FLUE) || (_channel == TEMP_SENSOR_FIREBOX))
+		return g_stoveSim.getSampleTime();
+#endif
+
+	if(!isInstalled(_channel))
+		return 0;
+
+	return m_sensors[_channel].getSampleTime();
+}
+
+uint32_t CTempSensorManager::getSampleSequence(int _channel)
+{
+#ifdef SIMULATION_MODE
+	if((_channel == TEMP_SENSOR_FLUE) || (_channel == TEMP_SENSOR_FIREBOX))
+		return g_stoveSim.getSampleSequence();
+#endif
+
+	if(!isInstalled(_channel))
+		return 0;
+
+	return m_sensors[_channel].getSampleSequence();
+}
+
+int CTempSensorManager::ambientTemperature()
+{
+#ifdef PIN_AMBIENT_THERMISTOR
+	return m_ambient.temperature();
+#else
+	return THERMOCOUPLE_INVALID_TEMP;
+#endif
+}
+
+int32_t CTempSensorManager::ambientTemperatureFixed()
+{
+#ifdef PIN_AMBIENT_THERMISTOR
+	return m_ambient.temperatureFixed();
+#else
+	return THERMOCOUPLE_INVALID_FIXED;
+#endif
+}
+
+CTempSensor_Thermocouple::CTempSensor_statusE CTempSensorManager::getStatus(int _channel)
+{
+#ifdef SIMULATION_MODE
+	if((_channel == TEMP_SENSOR_FLUE) || (_channel == TEMP_SENSOR_FIREBOX))
+		return CTempSensor_Thermocouple::status_ok;
+#endif
+
+	if(!isInstalled(_channel))
+		return CTempSensor_Thermocouple::status_open;
+
+	return m_sensors[_channel].getStatus();
+}
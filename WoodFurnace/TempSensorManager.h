@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////
+// Owns all of the thermocouples on the shared bus
+////////////////////////////////////////////////////
+#ifndef TempSensorManager_h
+#define TempSensorManager_h
+
+// Channel IDs (these are used as **array indices**)
+#define TEMP_SENSOR_FLUE		(0)
+#define TEMP_SENSOR_FIREBOX		(1)
+#define TEMP_SENSOR_PLENUM		(2)
+#define TEMP_SENSOR_COUNT		(3)
+
+////////////////////////////////////////////////////
+// The MAX6675 boards share SCK and SO, so only one
+// of them can be clocked at a time. Reads are spread
+// round-robin over slots, and each slot reads the next
+// channel that is due, so each channel is read once per
+// its read period and no pass through processFast()
+// does more than one SPI transaction.
+////////////////////////////////////////////////////
+class CTempSensorManager
+{
+protected:
+	CThermocoupleBus m_bus;
+	CTempSensor_Thermocouple m_sensors[TEMP_SENSOR_COUNT];
+	bool m_installed[TEMP_SENSOR_COUNT];
+	int m_nInstalled;
+
+	uint32_t m_readPeriod[TEMP_SENSOR_COUNT];
+	uint32_t m_lastReadTime[TEMP_SENSOR_COUNT];
+
+	int m_nextChannel;
+	uint32_t m_initMillis;
+	uint32_t m_lastSlotTime;
+	uint32_t m_slotTime;
+	bool m_warmedUp;
+
+	uint32_t m_statsSeconds;
+
+	// Optional ambient sensor
+#ifdef PIN_AMBIENT_THERMISTOR
+	CTempSensor_Thermistor m_ambient;
+	uint32_t m_lastAmbientTime;
+#endif
+
+	void addChannel(int _channel, int _csPin);
+	void updateSlotTime();
+
+public:
+	CTempSensorManager();
+	virtual ~CTempSensorManager();
+
+	void init();
+	void processFast();
+	void processOneSecond();
+
+	bool isInstalled(int _channel);
+
+	// How often a channel is read, THERMOCOUPLE_READ_PERIOD unless
+	// something needs it faster. No faster than THERMOCOUPLE_CONVERSION_TIME.
+	void setReadPeriod(int _channel, uint32_t _period);
+
+	int temperature(int _channel);
+	int32_t temperatureFixed(int _channel);
+
+	// Sample timing, so consumers can tell a new value
+	// from one they have already seen, and how old it is
+	uint32_t getSampleTime(int _channel);
+	uint32_t getSampleSequence(int _channel);
+	uint32_t getSampleAge(int _channel)
+	{
+		return millis() - getSampleTime(_channel);
+	}
+
+	// Ambient temperature, THERMOCOUPLE_INVALID_xxx if there
+	// is no ambient sensor (or it's not working)
+	int ambientTemperature();
+	int32_t ambientTemperatureFixed();
+
+	CTempSensor_Thermocouple::CTempSensor_statusE getStatus(int _channel);
+	bool isWarming(int _channel)
+	{
+		return getStatus(_channel) == CTempSensor_Thermocouple::status_warming;
+	}
+};
+
+#endif
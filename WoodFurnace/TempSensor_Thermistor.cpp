@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////
+// Ambient temperature from an NTC thermistor
+////////////////////////////////////////////////////
+#include <Arduino.h>
+#include <math.h>
+
+#include "Pins.h"
+#include "Defs.h"
+
+#include "SensorFilter.h"
+#include "TempSensor_Thermocouple.h"
+#include "TempSensor_Thermistor.h"
+
+// =================================================
+// 'structors
+// =================================================
+CTempSensor_Thermistor::CTempSensor_Thermistor()
+{
+	m_pin = -1;
+	m_valid = false;
+	m_tempFixed = THERMOCOUPLE_INVALID_FIXED;
+}
+
+CTempSensor_Thermistor::~CTempSensor_Thermistor()
+{
+}
+
+// =================================================
+// Prepare for operation
+// =================================================
+void CTempSensor_Thermistor::init(int _pin)
+{
+#ifdef DEBUG_TEMPSENSOR
+	Serial.println(F("CTempSensor_Thermistor::init()"));
+#endif
+
+	m_pin = _pin;
+	pinMode(m_pin, INPUT);
+}
+
+// =================================================
+// Operate
+// =================================================
+void CTempSensor_Thermistor::updateTemp()
+{
+	if(m_pin < 0)
+		return;
+
+	int adc = analogRead(m_pin);
+
+	// Pegged at either end means it's open or shorted
+	if((adc <= 0) || (adc >= THERMISTOR_ADC_MAX))
+	{
+#ifdef DEBUG_TEMPSENSOR
+		printUptime();
+		Serial.println(F("CTempSensor_Thermistor::updateTemp() - reading out of range"));
+#endif
+		m_valid = false;
+		return;
+	}
+
+	// Divider -> resistance -> beta equation
+	double ohms = THERMISTOR_SERIES_OHMS * adc / (THERMISTOR_ADC_MAX - adc);
+	double kelvin = 1. / ((log(ohms / THERMISTOR_NOMINAL_OHMS) / THERMISTOR_BETA) + (1. / THERMISTOR_NOMINAL_TEMP_K));
+	double fahrenheit = (kelvin - 273.15) * 9. / 5. + 32.;
+
+	int32_t newTemp = (int32_t)(fahrenheit * THERMOCOUPLE_FIXED_ONE);
+	if(!m_valid)
+		m_filter.reset(newTemp);
+
+	m_tempFixed = m_filter.process(newTemp, THERMISTOR_READ_PERIOD);
+	m_valid = true;
+
+#ifdef DEBUG_TEMPSENSOR
+	printUptime();
+	Serial.print(F("CTempSensor_Thermistor::updateTemp() - temp updated: "));
+	Serial.println(temperature());
+#endif
+}
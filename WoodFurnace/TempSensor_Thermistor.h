@@ -0,0 +1,42 @@
+////////////////////////////////////////////////////
+// Ambient temperature from an NTC thermistor
+////////////////////////////////////////////////////
+#ifndef TempSensor_Thermistor_H
+#define TempSensor_Thermistor_H
+
+// Wiring: 5V -- series resistor -- analog pin -- thermistor -- GND
+#define THERMISTOR_SERIES_OHMS		(10000.)
+#define THERMISTOR_NOMINAL_OHMS		(10000.)	// Resistance at 25C
+#define THERMISTOR_NOMINAL_TEMP_K	(298.15)	// 25C
+#define THERMISTOR_BETA				(3950.)
+#define THERMISTOR_ADC_MAX			(1023)
+
+#define THERMISTOR_READ_PERIOD		(5L * ONE_SECOND_MS)	// Ambient doesn't move fast
+#define THERMISTOR_EMA_ALPHA		(64)	// 0.25 in Q8
+
+////////////////////////////////////////////////////
+// Reads a cheap thermistor on an analog pin. The
+// conversion uses the beta equation in floating point,
+// but it only runs every THERMISTOR_READ_PERIOD.
+////////////////////////////////////////////////////
+class CTempSensor_Thermistor
+{
+private:
+	int m_pin;
+	bool m_valid;
+	int32_t m_tempFixed;
+	CEMAFilter<THERMISTOR_EMA_ALPHA> m_filter;
+
+public:
+	CTempSensor_Thermistor();
+	virtual ~CTempSensor_Thermistor();
+
+	void init(int _pin);
+	void updateTemp();
+
+	bool isValid() { return m_valid; }
+	int temperature() { return m_valid ? THERMOCOUPLE_FROM_FIXED(m_tempFixed) : THERMOCOUPLE_INVALID_TEMP; }
+	int32_t temperatureFixed() { return m_valid ? m_tempFixed : THERMOCOUPLE_INVALID_FIXED; }
+};
+
+#endif
@@ -2,16 +2,13 @@
 // Thermocouple temperature sensor based on MAX6675
 ////////////////////////////////////////////////////
 #include <Arduino.h>
-#include <max6675.h>
 
 #include "Pins.h"
 #include "Defs.h"
 
-#ifdef SIMULATION_MODE
-#include "StoveSim.h"
-extern CStoveSim g_stoveSim;
-#endif
+#include "SensorFilter.h"
 #include "TempSensor_Thermocouple.h"
+#include "ThermocoupleBus.h"
 
 // =================================================
 // 'structors
@@ -19,131 +16,146 @@ extern CStoveSim g_stoveSim;
 CTempSensor_Thermocouple::CTempSensor_Thermocouple()
 {
 	// Init instance variables
-	m_thermocoupleInterface = 0;
-
-	m_nextReadTime = 0;
+	m_status = status_warming;
+	m_csPin = -1;
+	m_lastSampleTime = 0;
+	m_sampleSequence = 0;
+	m_lastFrame = THERMOCOUPLE_FRAME_OPEN;
 
+	m_tempFixed = THERMOCOUPLE_INVALID_FIXED;
 	m_temp = THERMOCOUPLE_INVALID_TEMP;
+
+	m_lastGoodTime = 0;
+	m_goodReads = 0;
+	m_openReads = 0;
+	m_jumpReads = 0;
+	m_currentStreak = 0;
+	m_longestStreak = 0;
 }
 
 CTempSensor_Thermocouple::~CTempSensor_Thermocouple()
 {
-	if(m_thermocoupleInterface != 0)
-	{
-		MAX6675 *thermocouple = (MAX6675 *)m_thermocoupleInterface;
-		delete thermocouple;
-		m_thermocoupleInterface = 0;
-	}
 }
 
 // =================================================
 // Prepare for operation
 // =================================================
-void CTempSensor_Thermocouple::init()
+void CTempSensor_Thermocouple::init(int _csPin)
 {
 #ifdef DEBUG_TEMPSENSOR
-		Serial.println(F("CTempSensor_Thermocouple::init()"));
+		Serial.print(F("CTempSensor_Thermocouple::init() - CS pin: "));
+		Serial.println(_csPin);
 #endif
 
-	// Set Gnd pin for thermocouple interface
-#ifdef PIN_THERMOCOUPLE_GND
-	pinMode(PIN_THERMOCOUPLE_GND, OUTPUT);
-	digitalWrite(PIN_THERMOCOUPLE_GND, LOW);
-#endif
-
-	// Set VCC pin for thermocouple interface
-#ifdef PIN_THERMOCOUPLE_VCC
-	pinMode(PIN_THERMOCOUPLE_VCC, OUTPUT);
-	digitalWrite(PIN_THERMOCOUPLE_VCC, HIGH);
-#endif
+	m_csPin = _csPin;
 
 	// CS is an output, active low
-	pinMode(PIN_THERMOCOUPLE_CS, OUTPUT);
-	digitalWrite(PIN_THERMOCOUPLE_CS, HIGH);
-
-	// SCK is an output, active high
-	pinMode(PIN_THERMOCOUPLE_SCK, OUTPUT);
-	digitalWrite(PIN_THERMOCOUPLE_SCK, LOW);
+	pinMode(m_csPin, OUTPUT);
+	digitalWrite(m_csPin, HIGH);
 
-	// SO is an input / output, but we use it as input only
-	pinMode(PIN_THERMOCOUPLE_SO, INPUT);
-
-	// Let the chip stabilize
-	delay(500);		// This seems needed in order for the first reading to be correct
-
-	// Create the thermocouple interface
-	if(m_thermocoupleInterface == 0)
-	{
-		// Create the thermocouple interface
-		m_thermocoupleInterface = (void *)new MAX6675(PIN_THERMOCOUPLE_SCK, PIN_THERMOCOUPLE_CS, PIN_THERMOCOUPLE_SO);
-	}
+	// The first conversion is not valid until the chip has been
+	// powered for THERMOCOUPLE_WARMUP_TIME, so we report status_warming
+	// until CTempSensorManager takes the first reading.
+	m_status = status_warming;
 }
 
 // =================================================
 // Operate
 // =================================================
-void CTempSensor_Thermocouple::updateTemp()
+void CTempSensor_Thermocouple::updateTemp(CThermocoupleBus &_bus)
 {
-	// If the interface has been created then read the temperature
-	if(m_thermocoupleInterface)
-	{
-		MAX6675 *thermocouple = (MAX6675 *)m_thermocoupleInterface;
+	if(m_csPin < 0)
+		return;
+
+	uint32_t now = millis();
 
-		// Check for open thermocouple
-		if(isnan(thermocouple->readCelsius()))
-		{
+	// One frame gives us both the open-thermocouple bit and the temperature
+	m_lastFrame = _bus.readFrame(m_csPin);
+
+	// Check for open thermocouple
+	if(m_lastFrame & THERMOCOUPLE_FRAME_OPEN)
+	{
 #ifdef DEBUG_TEMPSENSOR
 		printUptime();
-		Serial.println(F("CTempSensor_Thermocouple::updateTemp() - readCelsius returned NaN"));
+		Serial.println(F("CTempSensor_Thermocouple::updateTemp() - thermocouple open"));
 #endif
-			m_temp = THERMOCOUPLE_INVALID_TEMP;
-			return;
-		}
-
-		// Smooth them out and store the results in actual
-		double newTemp = thermocouple->readFahrenheit();
-		if(m_temp == THERMOCOUPLE_INVALID_TEMP)
-			m_temp = newTemp;
+		m_openReads++;
+		badRead(now, status_open);
+		return;
+	}
 
-		m_temp = (newTemp * THERMOCOUPLE_EMA_ALPHA) +
-				(m_temp * (1. - THERMOCOUPLE_EMA_ALPHA));
+	// Quarter degrees C to Q8 degrees F: (q / 4) * 9 / 5 * 256 = q * 576 / 5
+	int32_t newTemp = ((int32_t)THERMOCOUPLE_FRAME_TEMP(m_lastFrame) * 576) / 5 + THERMOCOUPLE_TO_FIXED(32);
 
+	// Throw out readings that no real flue could produce
+	if((m_tempFixed != THERMOCOUPLE_INVALID_FIXED) &&
+	   (labs(newTemp - m_tempFixed) > THERMOCOUPLE_TO_FIXED(THERMOCOUPLE_MAX_JUMP)))
+	{
 #ifdef DEBUG_TEMPSENSOR
 		printUptime();
-		Serial.print(F("CTempSensor_Thermocouple::updateTemp() - temp updated: "));
-		Serial.println(m_temp);
+		Serial.println(F("CTempSensor_Thermocouple::updateTemp() - implausible jump"));
 #endif
-
+		m_jumpReads++;
+		badRead(now, status_holding);
+		return;
 	}
-	else
+
+	// Good reading
+	m_status = status_ok;
+	m_lastGoodTime = now;
+	m_goodReads++;
+	if(++m_currentStreak > m_longestStreak)
+		m_longestStreak = m_currentStreak;
+
+	// Smooth them out and store the results in actual. After a
+	// bad reading (or at startup) the filter restarts from this
+	// sample, with no time gone by so the slew limit can't hold
+	// it back toward whatever the probe read before it went bad.
+	uint32_t dt = now - m_lastSampleTime;
+	if(m_tempFixed == THERMOCOUPLE_INVALID_FIXED)
 	{
+		m_filter.reset(newTemp);
+		dt = 0;
+	}
+
+	m_tempFixed = m_filter.process(newTemp, dt);
+	m_temp = THERMOCOUPLE_FROM_FIXED(m_tempFixed);
+	m_lastSampleTime = now;
+	m_sampleSequence++;
+
 #ifdef DEBUG_TEMPSENSOR
-		printUptime();
-		Serial.println(F("CTempSensor_Thermocouple::updateTemp() - m_thermocoupleInterface == 0"));
+	printUptime();
+	Serial.print(F("CTempSensor_Thermocouple::updateTemp() - temp updated: "));
+	Serial.println(m_temp);
 #endif
-		m_temp = THERMOCOUPLE_INVALID_TEMP;
-	}
 }
 
-int CTempSensor_Thermocouple::temperature()
+// A flaky probe shouldn't flip the controller in and out of
+// alarm, so ride through bad reads on the last good value
+// for up to THERMOCOUPLE_HOLD_TIME before giving up on it.
+void CTempSensor_Thermocouple::badRead(uint32_t _now, CTempSensor_statusE _status)
 {
-#ifdef SIMULATION_MODE
-	return g_stoveSim.getTemperature();
-#endif
+	m_currentStreak = 0;
 
-	// Is it time to update the reading?
-	if((m_temp == THERMOCOUPLE_INVALID_TEMP) ||
-	   (millis() > m_nextReadTime))
+	if((m_tempFixed != THERMOCOUPLE_INVALID_FIXED) &&
+	   ((_now - m_lastGoodTime) < THERMOCOUPLE_HOLD_TIME))
 	{
-		// Yes, so read the hardware
-		updateTemp();
-
-		// Remember the next update time
-		m_nextReadTime = millis() + ONE_SECOND_MS;
+		m_status = status_holding;
+		return;
 	}
 
-	// Return latest temp reading
-	return m_temp;
+	m_status = (_status == status_holding) ? status_open : _status;
+	m_tempFixed = THERMOCOUPLE_INVALID_FIXED;
+	m_temp = THERMOCOUPLE_INVALID_TEMP;
 }
 
-
+void CTempSensor_Thermocouple::printStats()
+{
+	Serial.print(m_goodReads);
+	Serial.print(F(", "));
+	Serial.print(m_openReads);
+	Serial.print(F(", "));
+	Serial.print(m_jumpReads);
+	Serial.print(F(", "));
+	Serial.print(m_longestStreak);
+}
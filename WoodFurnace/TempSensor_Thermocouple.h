@@ -4,31 +4,114 @@
 #ifndef TempSensor_Thermocouple_H
 #define TempSensor_Thermocouple_H
 
-#define THERMOCOUPLE_EMA_ALPHA		(0.3)	// Exponential moving average
 #define THERMOCOUPLE_INVALID_TEMP	(-461)
+#define THERMOCOUPLE_WARMUP_TIME	(500L)	// ms after power-up before the first conversion can be trusted
+#define THERMOCOUPLE_READ_PERIOD	(ONE_SECOND_MS)	// How often each channel is read (by default)
+#define THERMOCOUPLE_CONVERSION_TIME	(250L)	// ms, the MAX6675 takes 220 ms to convert and reading it restarts the conversion
+#define THERMOCOUPLE_HOLD_TIME		(10L * ONE_SECOND_MS)	// How long to hold the last good reading through bad ones
+#define THERMOCOUPLE_MAX_JUMP		(100)	// Degrees F. A reading this far from the filtered value is not believable
+#define THERMOCOUPLE_STATS_INTERVAL	(60L)	// Seconds between sensor health reports on the serial log
+
+// MAX6675 frame layout (16 bits, MSB first)
+//	D15		dummy sign bit (always 0)
+//	D14-D3	12 bit temperature in 0.25C units
+//	D2		1 = thermocouple input open
+//	D1		device ID (always 0)
+//	D0		three-state
+#define THERMOCOUPLE_FRAME_BITS		(16)
+#define THERMOCOUPLE_FRAME_OPEN		(0x0004)
+#define THERMOCOUPLE_FRAME_TEMP(f)	(((f) >> 3) & 0x0FFF)
+
+// The filter runs in fixed point so the AVR doesn't have to do
+// software floating point, and so the fractional part of the
+// reading isn't truncated away on every sample. Temperatures
+// are held as degrees F * 256 (Q8).
+#define THERMOCOUPLE_FIXED_SHIFT	(8)
+#define THERMOCOUPLE_FIXED_ONE		((int32_t)1 << THERMOCOUPLE_FIXED_SHIFT)
+
+// Conditioning applied to each new reading:
+//	median of 3 to throw out single-sample SPI glitches
+//	exponential moving average to smooth the rest
+//	slew limit so nothing can move faster than the flue physically can
+#define THERMOCOUPLE_MEDIAN_SIZE	(3)
+#define THERMOCOUPLE_EMA_ALPHA		(77)	// Exponential moving average, 0.3 in Q8
+#define THERMOCOUPLE_SLEW_LIMIT		(25 * THERMOCOUPLE_FIXED_ONE)	// Degrees F per second
+
+#define THERMOCOUPLE_TO_FIXED(t)	((int32_t)(t) * THERMOCOUPLE_FIXED_ONE)
+#define THERMOCOUPLE_FROM_FIXED(t)	((int)(((t) + (THERMOCOUPLE_FIXED_ONE / 2)) >> THERMOCOUPLE_FIXED_SHIFT))
+#define THERMOCOUPLE_INVALID_FIXED	THERMOCOUPLE_TO_FIXED(THERMOCOUPLE_INVALID_TEMP)
+
+class CThermocoupleBus;
+
+typedef CSensorFilterChain<	CMedianFilter<THERMOCOUPLE_MEDIAN_SIZE>,
+							CEMAFilter<THERMOCOUPLE_EMA_ALPHA>,
+							CSlewLimiter<THERMOCOUPLE_SLEW_LIMIT> > CThermocoupleFilter;
 
 class CTempSensor_Thermocouple
 {
+public:
+	typedef enum
+	{
+		status_warming = 0,		// Waiting for the first conversion after power-up
+		status_ok,
+		status_open,			// Thermocouple not connected (or broken)
+		status_holding,			// Recent reads were bad, still reporting the last good one
+	} CTempSensor_statusE;
+
 private:
 	// Instance Vars
-	void *m_thermocoupleInterface;
-	unsigned long m_nextReadTime;
+	CTempSensor_statusE m_status;
+	int m_csPin;
+	uint32_t m_lastSampleTime;	// millis() when the current value was acquired
+	uint32_t m_sampleSequence;	// Bumped on every new good sample
+	CThermocoupleFilter m_filter;
+	unsigned int m_lastFrame;
+	int32_t m_tempFixed;
 	int m_temp;
 
-	// Private Methods
-	void updateTemp();
+	// Health statistics
+	uint32_t m_lastGoodTime;
+	uint32_t m_goodReads;
+	uint32_t m_openReads;
+	uint32_t m_jumpReads;
+	uint32_t m_currentStreak;
+	uint32_t m_longestStreak;
+
+	void badRead(uint32_t _now, CTempSensor_statusE _status);
 
 public:
 	// 'structors
 	CTempSensor_Thermocouple();
 	virtual ~CTempSensor_Thermocouple();
 
-	// Prep for operation
-	void init();
+	// Prep for operation. The shared SCK / SO bus is set
+	// up by CTempSensorManager, this only takes care of CS.
+	void init(int _csPin);
+
+	// Read the hardware now (CTempSensorManager decides when)
+	void updateTemp(CThermocoupleBus &_bus);
 
 	// Operate
-	int temperature();
+	int temperature() { return m_temp; }				// Whole degrees F, for display and the state machine
+	int32_t temperatureFixed() { return m_tempFixed; }	// Degrees F in Q8, for the PID
+
+	// When the current value was read, and a count that
+	// changes every time a new value arrives
+	uint32_t getSampleTime() { return m_lastSampleTime; }
+	uint32_t getSampleSequence() { return m_sampleSequence; }
+
+	CTempSensor_statusE getStatus() { return m_status; }
+	bool isWarming() { return m_status == status_warming; }
+
+	// Last raw frame clocked out of the MAX6675
+	unsigned int lastFrame() { return m_lastFrame; }
+
+	// Health statistics
+	uint32_t getGoodReads() { return m_goodReads; }
+	uint32_t getOpenReads() { return m_openReads; }
+	uint32_t getJumpReads() { return m_jumpReads; }
+	uint32_t getLongestStreak() { return m_longestStreak; }
+	void printStats();
 };
 
 #endif
-
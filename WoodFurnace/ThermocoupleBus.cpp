@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////
+// SPI bus shared by the MAX6675 boards
+////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Pins.h"
+#include "Defs.h"
+
+#ifdef THERMOCOUPLE_BUS_HW_SPI
+#include <SPI.h>
+#endif
+
+#include "SensorFilter.h"
+#include "TempSensor_Thermocouple.h"
+#include "ThermocoupleBus.h"
+
+#if !defined(THERMOCOUPLE_BUS_BITBANG) && !defined(THERMOCOUPLE_BUS_DIRECT) && !defined(THERMOCOUPLE_BUS_HW_SPI)
+#error Pick a thermocouple bus back end in Pins.h
+#endif
+
+#define THERMOCOUPLE_SPI_CLOCK		(4000000L)	// MAX6675 tops out at 4.3MHz
+
+// =================================================
+// 'structors
+// =================================================
+CThermocoupleBus::CThermocoupleBus()
+{
+#ifdef THERMOCOUPLE_BUS_DIRECT
+	m_sckPort = 0;
+	m_sckMask = 0;
+	m_soPort = 0;
+	m_soMask = 0;
+#endif
+}
+
+CThermocoupleBus::~CThermocoupleBus()
+{
+}
+
+// =================================================
+// Prepare for operation
+// =================================================
+void CThermocoupleBus::init()
+{
+	// Set Gnd pin for thermocouple interface
+#ifdef PIN_THERMOCOUPLE_GND
+	pinMode(PIN_THERMOCOUPLE_GND, OUTPUT);
+	digitalWrite(PIN_THERMOCOUPLE_GND, LOW);
+#endif
+
+	// Set VCC pin for thermocouple interface
+#ifdef PIN_THERMOCOUPLE_VCC
+	pinMode(PIN_THERMOCOUPLE_VCC, OUTPUT);
+	digitalWrite(PIN_THERMOCOUPLE_VCC, HIGH);
+#endif
+
+#ifdef THERMOCOUPLE_BUS_HW_SPI
+	SPI.begin();
+#else
+	// SCK is an output, active high
+	pinMode(PIN_THERMOCOUPLE_SCK, OUTPUT);
+	digitalWrite(PIN_THERMOCOUPLE_SCK, LOW);
+
+	// SO is an input / output, but we use it as input only
+	pinMode(PIN_THERMOCOUPLE_SO, INPUT);
+#endif
+
+#ifdef THERMOCOUPLE_BUS_DIRECT
+	// Look up the port registers once rather than on every bit
+	m_sckPort = portOutputRegister(digitalPinToPort(PIN_THERMOCOUPLE_SCK));
+	m_sckMask = digitalPinToBitMask(PIN_THERMOCOUPLE_SCK);
+	m_soPort = portInputRegister(digitalPinToPort(PIN_THERMOCOUPLE_SO));
+	m_soMask = digitalPinToBitMask(PIN_THERMOCOUPLE_SO);
+#endif
+}
+
+// =================================================
+// Operate
+// =================================================
+// Clock one complete frame out of the MAX6675. Pulling CS low
+// stops the conversion in progress and latches the last result,
+// raising it again starts the next conversion. So we only
+// ever want one frame per sample.
+unsigned int CThermocoupleBus::readFrame(int _csPin)
+{
+#ifdef DEBUG_TEMPSENSOR
+	uint32_t startMicros = micros();
+#endif
+
+	unsigned int frame = 0;
+
+#ifdef THERMOCOUPLE_BUS_HW_SPI
+	// The clock polarity has to be set before CS goes low, the
+	// last device on the bus may have left SCK idling high
+	SPI.beginTransaction(SPISettings(THERMOCOUPLE_SPI_CLOCK, MSBFIRST, SPI_MODE0));
+#endif
+
+	digitalWrite(_csPin, LOW);
+	delayMicroseconds(1);
+
+#if defined(THERMOCOUPLE_BUS_HW_SPI)
+
+	frame = SPI.transfer16(0);
+
+#elif defined(THERMOCOUPLE_BUS_DIRECT)
+
+	// Nothing else writes these ports from an interrupt, but
+	// keep the read-modify-writes atomic anyway. Even with
+	// no delays each half clock is several cycles, well over
+	// the MAX6675's 100ns minimum.
+	noInterrupts();
+	for(int _ = 0; _ < THERMOCOUPLE_FRAME_BITS; ++_)
+	{
+		*m_sckPort &= ~m_sckMask;
+
+		frame <<= 1;
+		if(*m_soPort & m_soMask)
+			frame |= 1;
+
+		*m_sckPort |= m_sckMask;
+	}
+	*m_sckPort &= ~m_sckMask;
+	interrupts();
+
+#else
+
+	for(int _ = 0; _ < THERMOCOUPLE_FRAME_BITS; ++_)
+	{
+		// The MAX6675 shifts out the next bit on the falling
+		// edge of SCK, so sample SO while SCK is low.
+		digitalWrite(PIN_THERMOCOUPLE_SCK, LOW);
+		delayMicroseconds(1);
+
+		frame <<= 1;
+		if(digitalRead(PIN_THERMOCOUPLE_SO))
+			frame |= 1;
+
+		digitalWrite(PIN_THERMOCOUPLE_SCK, HIGH);
+		delayMicroseconds(1);
+	}
+	digitalWrite(PIN_THERMOCOUPLE_SCK, LOW);
+
+#endif
+
+	digitalWrite(_csPin, HIGH);
+
+#ifdef THERMOCOUPLE_BUS_HW_SPI
+	SPI.endTransaction();
+#endif
+
+#ifdef DEBUG_TEMPSENSOR
+	printUptime();
+	Serial.print(F("CThermocoupleBus::readFrame() - uS: "));
+	Serial.println(micros() - startMicros);
+#endif
+
+	return frame;
+}
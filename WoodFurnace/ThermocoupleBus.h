@@ -0,0 +1,31 @@
+////////////////////////////////////////////////////
+// SPI bus shared by the MAX6675 boards
+////////////////////////////////////////////////////
+#ifndef ThermocoupleBus_h
+#define ThermocoupleBus_h
+
+////////////////////////////////////////////////////
+// Clocks frames out of a MAX6675. The back end is
+// chosen in Pins.h (THERMOCOUPLE_BUS_xxx).
+////////////////////////////////////////////////////
+class CThermocoupleBus
+{
+protected:
+#ifdef THERMOCOUPLE_BUS_DIRECT
+	volatile uint8_t *m_sckPort;
+	uint8_t m_sckMask;
+	volatile uint8_t *m_soPort;
+	uint8_t m_soMask;
+#endif
+
+public:
+	CThermocoupleBus();
+	virtual ~CThermocoupleBus();
+
+	void init();
+
+	// One complete 16 bit frame from the chip on _csPin
+	unsigned int readFrame(int _csPin);
+};
+
+#endif
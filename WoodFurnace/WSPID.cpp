@@ -1,96 +1,437 @@
 ////////////////////////////////////////////////////////////
-// WSPID wrapper around PID_v1
+// WSPID - fixed point PID controller
 ////////////////////////////////////////////////////////////
 
 #include <Arduino.h>
 
-#include <PID_v1.h>
-
+#include "Defs.h"
 #include "WSPID.h"
 
 ////////////////////////////////////////////////////////////
-// Make PID_v1 more acceptable to my stylistic tastes, and
-// add scaling to make it easier to match the scale of the
-// to setpoint to the range of the control output.
+// A PID that works the same way PID_v1 does, in integer math
 ////////////////////////////////////////////////////////////
 CWSPID::CWSPID()
 {
-	m_input = m_output = m_setpoint = 0.;
+	m_input = m_setpoint = m_output = 0;
+	m_iTerm = m_dTerm = m_lastInput = 0;
+	m_feedforward = 0;
+	m_filtered = 0;
+
+	m_outMin = m_iMin = 0;
+	m_outMax = m_iMax = 255 * WSPID_OUTPUT_ONE;
+	m_deadZone = 0;
+
+	m_dispKp = m_dispKi = m_dispKd = 0.;
 	m_scale = 1.;
+	m_gainsClamped = false;
+
+	m_mode = MANUAL;
+	m_iFrozen = false;
+	m_tracking = false;
+	m_trackTarget = 0;
+	m_trackingTime = 0;
+	m_dFilterTime = 0;
+	m_ffDecayTime = 0;
+	m_oFilterTime = 0;
 
-	// Create the PID controller
-	m_pid = new PID(&m_input, &m_output, &m_setpoint, 0., 0., 0., DIRECT);
+	m_lastSequence = 0;
+	m_lastSampleTime = 0;
+	m_sampleTime = 100;
+
+	updateGains();
 }
 
 CWSPID::~CWSPID()
 {
-	delete m_pid;
-	m_pid = 0;
 }
 
 void CWSPID::SetMode(int Mode)
 {
-	m_pid->SetMode(Mode);
+	// Going to automatic, pick up where manual left off
+	if((Mode == AUTOMATIC) && (m_mode == MANUAL))
+		initialize();
+
+	m_mode = Mode;
 }
 
 int CWSPID::GetMode()
 {
-	return m_pid->GetMode();
+	return m_mode;
+}
+
+void CWSPID::SetOutputLimits(int Min, int Max)
+{
+	if(Min >= Max)
+		return;
+
+	m_outMin = m_iMin = (int32_t)Min * WSPID_OUTPUT_ONE;
+	m_outMax = m_iMax = (int32_t)Max * WSPID_OUTPUT_ONE;
+
+	if(m_mode == AUTOMATIC)
+	{
+		m_output = clampOutput(m_output);
+		m_filtered = clampOutput(m_filtered);
+		m_iTerm = clampIntegrator(m_iTerm);
+	}
+}
+
+void CWSPID::SetIntegratorLimits(int _min, int _max)
+{
+	if(_min >= _max)
+		return;
+
+	m_iMin = max((int32_t)_min * WSPID_OUTPUT_ONE, m_outMin);
+	m_iMax = min((int32_t)_max * WSPID_OUTPUT_ONE, m_outMax);
+	m_iTerm = clampIntegrator(m_iTerm);
+}
+
+void CWSPID::SetDeadZone(int _deadZone, int32_t _trackingTime)
+{
+	m_deadZone = (int32_t)_deadZone * WSPID_OUTPUT_ONE;
+	m_trackingTime = _trackingTime;
+	updateGains();
+}
+
+void CWSPID::SetTrackingTime(int32_t _trackingTime)
+{
+	m_trackingTime = _trackingTime;
+	updateGains();
 }
 
-void CWSPID::SetOutputLimits(double Min, double Max)
+void CWSPID::TrackOutput(int _achieved)
 {
-	m_pid->SetOutputLimits(Min, Max);
+	m_trackTarget = clampOutput((int32_t)_achieved * WSPID_OUTPUT_ONE);
+	m_tracking = true;
+}
+
+void CWSPID::SetDerivativeFilter(int32_t _filterTime)
+{
+	m_dFilterTime = _filterTime;
+	updateGains();
+}
+
+void CWSPID::SetOutputFilter(int32_t _filterTime)
+{
+	m_oFilterTime = _filterTime;
+	updateGains();
+}
+
+void CWSPID::SetFeedforwardDecay(int32_t _decayTime)
+{
+	m_ffDecayTime = _decayTime;
+	updateGains();
+}
+
+void CWSPID::AddFeedforward(int _bias)
+{
+	if(m_mode != AUTOMATIC)
+		return;
+
+	m_feedforward += (int32_t)_bias * WSPID_OUTPUT_ONE;
+}
+
+// The feedforward isn't part of the preload, it is a transient on top
+void CWSPID::PreloadIntegrator(int _output)
+{
+	// Whatever P is doing right now is already in the output
+	int32_t pTerm = clampTerm(gainMultiply(m_kp, clampSignal(m_setpoint - m_input)));
+
+	m_output = m_filtered = clampOutput((int32_t)_output * WSPID_OUTPUT_ONE);
+	m_iTerm = clampIntegrator(m_output - pTerm);
+	m_dTerm = 0;
+	m_lastInput = m_input;
 }
 
 void CWSPID::SetSampleTime(int NewSampleTime)
 {
-	m_pid->SetSampleTime(NewSampleTime);
+	if(NewSampleTime > 0)
+	{
+		m_sampleTime = NewSampleTime;
+		updateGains();
+	}
 }
 
-void CWSPID::SetTunings(double Kp, double Ki, double Kd)
+bool CWSPID::SetTunings(double Kp, double Ki, double Kd)
 {
-	m_pid->SetTunings(Kp, Ki, Kd);
+	if(Kp < 0 || Ki < 0 || Kd < 0)
+		return false;
+
+	m_dispKp = Kp;
+	m_dispKi = Ki;
+	m_dispKd = Kd;
+
+	CWSPID_gainT oldKp = m_kp;
+	updateGains();
+
+	// Switching gains on the fly would step the P term, so move
+	// the difference into the integrator to keep the output where
+	// it was. Ki is already applied as the error is integrated, so
+	// changing it doesn't bump anything.
+	if(m_mode == AUTOMATIC)
+	{
+		int32_t error = clampSignal(m_setpoint - m_input);
+
+		m_iTerm += clampTerm(gainMultiply(oldKp, error)) - clampTerm(gainMultiply(m_kp, error));
+		m_iTerm = clampIntegrator(m_iTerm);
+	}
+
+	return !m_gainsClamped;
 }
 
 double CWSPID::GetKp()
 {
-	return m_pid->GetKp();
+	return m_dispKp;
 }
 
 double CWSPID::GetKi()
 {
-	return m_pid->GetKi();
+	return m_dispKi;
 }
 
 double CWSPID::GetKd()
 {
-	return m_pid->GetKd();
+	return m_dispKd;
+}
+
+void CWSPID::SetSetpoint(int _setpoint)
+{
+	SetSetpointFixed((int32_t)_setpoint * WSPID_FIXED_ONE);
 }
 
-void CWSPID::SetSetpoint(double _setpoint)
+void CWSPID::SetSetpointFixed(int32_t _setpoint)
 {
-	m_setpoint = _setpoint * m_scale;
+	m_setpoint = _setpoint;
 }
 
-double CWSPID::Compute(double _input)
+int CWSPID::Compute(int32_t _input, uint32_t _sequence, uint32_t _sampleTime)
 {
-	m_input = _input * m_scale;
+	// Nothing new, nothing to do
+	if(_sequence != m_lastSequence)
+	{
+		// Time between samples. Gaps much longer than expected
+		// (startup, a stalled loop) are held to twice the nominal
+		// sample time so one late sample can't kick the integrator.
+		int32_t dt = (int32_t)(_sampleTime - m_lastSampleTime);
+		if((dt <= 0) || (dt > (2 * m_sampleTime)))
+			dt = m_sampleTime;
+
+		m_input = _input;
+		m_lastSequence = _sequence;
+		m_lastSampleTime = _sampleTime;
+
+		if(m_mode == AUTOMATIC)
+		{
+			// How far this dt is from the nominal the gains were
+			// worked out for, Q8. Almost always exactly 1.
+			int32_t ratio = WSPID_RATIO_ONE;
+			if(dt != m_sampleTime)
+				ratio = max((dt << WSPID_RATIO_SHIFT) / m_sampleTime, WSPID_RATIO_MIN);
+
+			int32_t error = clampSignal(m_setpoint - m_input);
+			int32_t dInput = clampSignal(m_input - m_lastInput);
+
+			// Integral, clamped to the integrator limits
+			if(!m_iFrozen)
+			{
+				m_iTerm += scaleByRatio(clampTerm(gainMultiply(m_kiStep, error)), ratio);
+				m_iTerm = clampIntegrator(m_iTerm);
+			}
+
+			// Proportional on error, derivative on measurement
+			int32_t pTerm = clampTerm(gainMultiply(m_kp, error));
+			int32_t dTerm = clampTerm(gainMultiply(m_kdStep, dInput));
+			if(ratio != WSPID_RATIO_ONE)
+				dTerm = clampTerm(divideByRatio(dTerm, ratio));
+
+			// Filtered with the real time between samples (with the
+			// filter off the step is all the way)
+			m_dTerm += multiplyFraction(dTerm - m_dTerm, scaleFraction(m_dAlpha, ratio));
+
+			// Feedforward decays with the real time between samples too
+			m_feedforward -= multiplyFraction(m_feedforward, scaleFraction(m_ffBeta, ratio));
+
+			int32_t output = clampOutput(pTerm + m_iTerm - m_dTerm + m_feedforward);
+
+			// With the filter off the step is all the way
+			m_filtered += multiplyFraction(output - m_filtered, scaleFraction(m_oAlpha, ratio));
+			output = m_filtered;
+			m_output = applyDeadZone(output);
+
+			// Back-calculation, pull the integrator toward what
+			// the output can actually deliver
+			int32_t achieved = m_tracking ? m_trackTarget : m_output;
+			if((m_trackStep > 0) && !m_iFrozen && (achieved != output))
+			{
+				m_iTerm += multiplyFraction(achieved - output, scaleFraction(m_trackStep, ratio));
+				m_iTerm = clampIntegrator(m_iTerm);
+			}
+		}
 
-	m_pid->Compute();
+		m_lastInput = m_input;
+	}
 
-	return m_output;
+	return GetOutput();
 }
 
 void CWSPID::SetScale(double _scale)
 {
 	m_scale = _scale;
+	updateGains();
 }
 
-void CWSPID::SetOutput(double _o)
+void CWSPID::SetOutput(int _o)
 {
 	if(GetMode() == AUTOMATIC)
 		return;
 
-	m_output = _o;
+	m_output = (int32_t)_o * WSPID_OUTPUT_ONE;
+}
+
+int CWSPID::GetOutput()
+{
+	// Rounded to the nearest whole count
+	return (int)((m_output + (WSPID_OUTPUT_ONE / 2)) >> WSPID_OUTPUT_SHIFT);
+}
+
+////////////////////////////////////////////////////////////
+// Internals
+void CWSPID::updateGains()
+{
+	// Float math only happens here, when the tunings change. Ki
+	// is per second and Kd times seconds, fold in the sample time.
+	double perSample = (double)m_sampleTime / ONE_SECOND_MS;
+
+	m_gainsClamped = false;
+	m_dispKp = limitGain(m_dispKp, m_scale);
+	m_dispKi = limitGain(m_dispKi, m_scale * perSample);
+	m_dispKd = limitGain(m_dispKd, m_scale / perSample);
+
+	m_kp = makeGain(m_dispKp * m_scale);
+	m_kiStep = makeGain(m_dispKi * m_scale * perSample);
+	m_kdStep = makeGain(m_dispKd * m_scale / perSample);
+
+	m_dAlpha = fractionOf(m_sampleTime, m_dFilterTime + m_sampleTime);
+	m_oAlpha = fractionOf(m_sampleTime, m_oFilterTime + m_sampleTime);
+	m_ffBeta = (m_ffDecayTime > 0) ? fractionOf(m_sampleTime, m_ffDecayTime + m_sampleTime) : 0;
+	m_trackStep = (m_trackingTime > 0) ? fractionOf(m_sampleTime, m_trackingTime) : 0;
+}
+
+// A gain the mantissa can't hold comes back as the largest one it
+// can, in the same units it was given in
+float CWSPID::limitGain(float _gain, double _factor)
+{
+	// Anything that rounds to the largest mantissa still fits
+	if(_gain * _factor * (WSPID_OUTPUT_ONE / WSPID_FIXED_ONE) < WSPID_MANTISSA_MAX + 0.5)
+		return _gain;
+
+	m_gainsClamped = true;
+	return WSPID_GAIN_MAX / _factor;
+}
+
+void CWSPID::initialize()
+{
+	m_iTerm = clampIntegrator(m_output);
+	m_dTerm = 0;
+	m_feedforward = 0;
+	m_filtered = clampOutput(m_output);
+	m_lastInput = m_input;
+}
+
+int32_t CWSPID::clampIntegrator(int32_t _value)
+{
+	if(_value > m_iMax)
+		return m_iMax;
+	if(_value < m_iMin)
+		return m_iMin;
+	return _value;
+}
+
+int32_t CWSPID::applyDeadZone(int32_t _value)
+{
+	if((_value <= 0) || (_value >= m_deadZone))
+		return _value;
+
+	// Round to whichever end is closer
+	return (_value < (m_deadZone / 2)) ? 0 : m_deadZone;
+}
+
+int32_t CWSPID::clampOutput(int32_t _value)
+{
+	if(_value > m_outMax)
+		return m_outMax;
+	if(_value < m_outMin)
+		return m_outMin;
+	return _value;
+}
+
+CWSPID::CWSPID_gainT CWSPID::makeGain(double _gain)
+{
+	// Q8 in, Q16 out
+	double gain = _gain * (WSPID_OUTPUT_ONE / WSPID_FIXED_ONE);
+
+	// The most fraction bits that still fit the mantissa
+	CWSPID_gainT result;
+	result.m_shift = WSPID_SHIFT_MAX;
+	while((result.m_shift > 0) && (gain * ((int32_t)1 << result.m_shift) > WSPID_MANTISSA_MAX))
+		--result.m_shift;
+
+	result.m_mantissa = min((int32_t)(gain * ((int32_t)1 << result.m_shift) + 0.5), WSPID_MANTISSA_MAX);
+	return result;
+}
+
+int32_t CWSPID::fractionOf(int32_t _time, int32_t _span)
+{
+	if(_time >= _span)
+		return WSPID_FRACTION_ONE;
+
+	return (int32_t)((double)_time * WSPID_FRACTION_ONE / _span + 0.5);
+}
+
+int32_t CWSPID::gainMultiply(const CWSPID_gainT &_gain, int32_t _x)
+{
+	// Under 2^30 with _x clamped, so there is room to round
+	int32_t product = _gain.m_mantissa * _x;
+	if(_gain.m_shift == 0)
+		return product;
+
+	return (product + ((int32_t)1 << (_gain.m_shift - 1))) >> _gain.m_shift;
+}
+
+int32_t CWSPID::clampSignal(int32_t _value)
+{
+	return constrain(_value, -WSPID_SIGNAL_MAX, WSPID_SIGNAL_MAX);
+}
+
+int32_t CWSPID::clampTerm(int32_t _value)
+{
+	return constrain(_value, -WSPID_TERM_MAX, WSPID_TERM_MAX);
+}
+
+// The multiplies below are split in a high and a low part so
+// neither can overflow, the low part unsigned and rounded
+int32_t CWSPID::scaleByRatio(int32_t _value, int32_t _ratio)
+{
+	uint32_t low = ((uint32_t)(_value & 0xFF) * _ratio + (WSPID_RATIO_ONE / 2)) >> WSPID_RATIO_SHIFT;
+	return (_value >> WSPID_RATIO_SHIFT) * _ratio + (int32_t)low;
+}
+
+int32_t CWSPID::divideByRatio(int32_t _value, int32_t _ratio)
+{
+	int32_t quotient = _value / _ratio;
+	int32_t remainder = _value % _ratio;
+	return quotient * WSPID_RATIO_ONE + (remainder * WSPID_RATIO_ONE) / _ratio;
+}
+
+int32_t CWSPID::scaleFraction(int32_t _fraction, int32_t _ratio)
+{
+	if(_ratio == WSPID_RATIO_ONE)
+		return _fraction;
+
+	return min((_fraction * _ratio + (WSPID_RATIO_ONE / 2)) >> WSPID_RATIO_SHIFT, WSPID_FRACTION_ONE);
+}
+
+int32_t CWSPID::multiplyFraction(int32_t _value, int32_t _fraction)
+{
+	uint32_t low = ((uint32_t)(_value & 0xFFFF) * _fraction + (WSPID_FRACTION_ONE / 2)) >> WSPID_FRACTION_SHIFT;
+	return (_value >> WSPID_FRACTION_SHIFT) * _fraction + (int32_t)low;
 }
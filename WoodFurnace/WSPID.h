@@ -1,25 +1,133 @@
 ////////////////////////////////////////////////////////////
-// WSPID wrapper around PID_v1
+// WSPID - fixed point PID controller
 ////////////////////////////////////////////////////////////
 #ifndef WSPID_h
 #define WSPID_h
 
+// Modes (same values PID_v1 used)
+#define MANUAL		(0)
+#define AUTOMATIC	(1)
+
+// Inputs, setpoints and outputs are fixed point with this many
+// fraction bits (Q8, the same as the thermocouple readings)
+#define WSPID_FIXED_SHIFT	(8)
+#define WSPID_FIXED_ONE		((int32_t)1 << WSPID_FIXED_SHIFT)
+
+// The output and integrator are Q16 internally so small errors
+// still move the integrator instead of being truncated away
+#define WSPID_OUTPUT_SHIFT	(16)
+#define WSPID_OUTPUT_ONE	((int32_t)1 << WSPID_OUTPUT_SHIFT)
+
+// Everything in Compute() stays inside a long. Errors and input
+// changes are clamped to +/- 1024F, gains are a 12 bit mantissa and
+// a right shift, so a gain times an error is under 2^30. That holds
+// a gain to just under 16 PWM counts per degree per sample (after
+// the scale), anything larger is clamped there and SetTunings()
+// says so.
+#define WSPID_SIGNAL_MAX	(((int32_t)1024 << WSPID_FIXED_SHIFT) - 1)
+#define WSPID_MANTISSA_MAX	((int32_t)4095)
+#define WSPID_SHIFT_MAX		(30)
+#define WSPID_GAIN_MAX		((double)WSPID_MANTISSA_MAX * WSPID_FIXED_ONE / WSPID_OUTPUT_ONE)
+
+// Single terms are held to +/- 2048 counts before dt is applied,
+// well past any output limit
+#define WSPID_TERM_MAX		(((int32_t)2048 << WSPID_OUTPUT_SHIFT) - 1)
+
+// dt as a fraction of the nominal sample time, Q8, between 1/8 and 2
+#define WSPID_RATIO_SHIFT	(8)
+#define WSPID_RATIO_ONE		((int32_t)1 << WSPID_RATIO_SHIFT)
+#define WSPID_RATIO_MIN		(WSPID_RATIO_ONE / 8)
+
+// Filter and decay steps, the Q16 fraction of the way to go per sample
+#define WSPID_FRACTION_SHIFT	(16)
+#define WSPID_FRACTION_ONE		((int32_t)1 << WSPID_FRACTION_SHIFT)
+
 ////////////////////////////////////////////////////////////
-// Make PID_v1 more acceptable to my stylistic tastes, and
-// add scaling to make it easier to match the scale of the
-// to setpoint to the range of the control output.
+// A PID that works the same way PID_v1 does (derivative on
+// measurement, integrator clamped to the output limits, bumpless
+// MANUAL -> AUTOMATIC), but in 32 bit integer math with no heap.
+// That keeps software floating point and 64 bit multiplies and
+// divides off the AVR's main loop.
+//
+// Scaling makes it easier to match the scale of the setpoint to
+// the range of the control output. It is folded into the gains.
 ////////////////////////////////////////////////////////////
 class CWSPID
 {
 protected:
+	// A gain as (mantissa * x) >> shift, see makeGain()
+	typedef struct
+	{
+		int32_t m_mantissa;
+		unsigned char m_shift;
+	} CWSPID_gainT;
+
+	// Fixed point state
+	int32_t m_input;		// Q8
+	int32_t m_setpoint;		// Q8
+	int32_t m_lastInput;	// Q8
+	int32_t m_output;		// Q16
+	int32_t m_iTerm;		// Q16
+	int32_t m_dTerm;		// Q16, filtered
+	int32_t m_feedforward;	// Q16, decaying
+	int32_t m_filtered;		// Q16, low-passed output
+	int32_t m_outMin;		// Q16
+	int32_t m_outMax;		// Q16
+	int32_t m_iMin;			// Q16
+	int32_t m_iMax;			// Q16
+	int32_t m_deadZone;		// Q16
+
+	// Working gains with the scale applied, Q8 error in and Q16
+	// output out. Ki and Kd are already per nominal sample, Compute()
+	// only corrects them by how far dt is off the nominal.
+	CWSPID_gainT m_kp;
+	CWSPID_gainT m_kiStep;
+	CWSPID_gainT m_kdStep;
 
-	double m_input;
-	double m_output;
-	double m_setpoint;
+	// Per nominal sample, Q16 fractions
+	int32_t m_dAlpha;		// D filter, dt / (filter time + dt)
+	int32_t m_ffBeta;		// Feedforward decay, dt / (decay time + dt)
+	int32_t m_oAlpha;		// Output filter, dt / (filter time + dt)
+	int32_t m_trackStep;	// Back-calculation, dt / tracking time
 
-	double m_scale;
+	// Gains as they were given to us
+	float m_dispKp;
+	float m_dispKi;
+	float m_dispKd;
+	float m_scale;
+	bool m_gainsClamped;
 
-	PID *m_pid;
+	int m_mode;
+	bool m_iFrozen;
+	bool m_tracking;
+	int32_t m_trackTarget;		// Q16
+	int32_t m_trackingTime;		// ms, 0 turns back-calculation off
+	int32_t m_dFilterTime;		// ms, 0 turns the derivative filter off
+	int32_t m_ffDecayTime;		// ms, 0 holds the feedforward until cleared
+	int32_t m_oFilterTime;		// ms, 0 turns the output filter off
+
+	// The sample the last Compute() was based on
+	uint32_t m_lastSequence;
+	uint32_t m_lastSampleTime;
+	int m_sampleTime;
+
+	void updateGains();
+	float limitGain(float _gain, double _factor);
+	void initialize();
+	int32_t clampOutput(int32_t _value);
+	int32_t clampIntegrator(int32_t _value);
+	int32_t applyDeadZone(int32_t _value);
+
+	// 32 bit helpers for Compute()
+	static CWSPID_gainT makeGain(double _gain);
+	static int32_t fractionOf(int32_t _time, int32_t _span);
+	static int32_t gainMultiply(const CWSPID_gainT &_gain, int32_t _x);
+	static int32_t clampSignal(int32_t _value);
+	static int32_t clampTerm(int32_t _value);
+	static int32_t scaleByRatio(int32_t _value, int32_t _ratio);
+	static int32_t divideByRatio(int32_t _value, int32_t _ratio);
+	static int32_t scaleFraction(int32_t _fraction, int32_t _ratio);
+	static int32_t multiplyFraction(int32_t _value, int32_t _fraction);
 
 public:
 	CWSPID();
@@ -28,20 +136,70 @@ public:
 	void SetMode(int Mode);
 	int GetMode();
 
-	void SetOutputLimits(double Min, double Max);
+	void SetOutputLimits(int Min, int Max);
 	void SetSampleTime(int NewSampleTime);
-	void SetTunings(double Kp, double Ki, double Kd);
+	// Bumpless, so it is safe to call while in AUTOMATIC. Returns
+	// false if a gain was past WSPID_GAIN_MAX and had to be clamped,
+	// GetKp() etc. then return the gains really in use.
+	bool SetTunings(double Kp, double Ki, double Kd);
+	bool GetTuningsClamped() { return m_gainsClamped; }
 
 	double GetKp();
 	double GetKi();
 	double GetKd();
 
-	void SetSetpoint(double _setpoint);
+	void SetSetpoint(int _setpoint);
+	void SetSetpointFixed(int32_t _setpoint);
 
-	double Compute(double _input);
+	// Only recomputes when a new sample (_sequence) has arrived, and
+	// uses the time between samples as the PID's dt. Input is Q8,
+	// the result is the rounded output.
+	int Compute(int32_t _input, uint32_t _sequence, uint32_t _sampleTime);
 	void SetScale(double _scale);
 
-	void SetOutput(double _o);
+	void SetOutput(int _o);
+	int GetOutput();
+
+	// Integrator management. Preload sets the integrator so the
+	// output continues from _output without a bump. Frozen, the
+	// integrator holds its value (while the output isn't reaching
+	// the plant, for instance). The integrator limits default to
+	// the output limits and must be set after them.
+	void PreloadIntegrator(int _output);
+	void FreezeIntegrator(bool _freeze) { m_iFrozen = _freeze; }
+	void SetIntegratorLimits(int _min, int _max);
+
+	// Outputs between 0 and _deadZone can't be delivered (the blower
+	// stalls), so they are rounded to 0 or _deadZone. The difference
+	// is fed back into the integrator with time constant _trackingTime
+	// (ms), so it doesn't wind up against something it can't get.
+	void SetDeadZone(int _deadZone, int32_t _trackingTime);
+
+	// Back-calculation toward what something downstream can really
+	// deliver (an inner loop that is saturated, in a cascade). While
+	// tracking, the integrator is pulled toward _achieved with the
+	// tracking time constant instead of winding up against it.
+	void SetTrackingTime(int32_t _trackingTime);
+	void TrackOutput(int _achieved);
+	void StopTracking() { m_tracking = false; }
+
+	// First order low-pass on the D term, time constant in ms. With
+	// whole degree readings the raw derivative is mostly steps.
+	void SetDerivativeFilter(int32_t _filterTime);
+
+	// First order low-pass on the output, ahead of the dead zone,
+	// time constant in ms. For a fast loop on a coarse reading
+	// where every tick moves the output by the whole of Kp.
+	void SetOutputFilter(int32_t _filterTime);
+
+	// Feedforward. A bias (PWM counts) added straight to the output
+	// when something we know about is going to change what the plant
+	// needs, so we can lead the disturbance instead of waiting for
+	// the error. It decays away with time constant _decayTime (ms)
+	// as the feedback loop catches up. Going to AUTOMATIC clears it.
+	void SetFeedforwardDecay(int32_t _decayTime);
+	void AddFeedforward(int _bias);
+	void ClearFeedforward() { m_feedforward = 0; }
 };
 
 #endif
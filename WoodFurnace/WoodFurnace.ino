@@ -1,6 +1,5 @@
 #include <Arduino.h>
 
-#include <PID_v1.h>
 #include <SaveController.h>
 
 #include "Pins.h"
@@ -9,9 +8,13 @@
 #include "MilliTimer.h"
 
 //////////////////////////////////////////////////////
-// The thermocouple
+// The thermocouples
+#include "SensorFilter.h"
 #include "TempSensor_Thermocouple.h"
-CTempSensor_Thermocouple g_thermocouple;
+#include "ThermocoupleBus.h"
+#include "TempSensor_Thermistor.h"
+#include "TempSensorManager.h"
+CTempSensorManager g_tempSensors;
 
 //////////////////////////////////////////////////////
 // LCD Display
@@ -39,6 +42,10 @@ CScreenController g_screenController;
 //////////////////////////////////////////////////////
 // Temperature Controller
 #include "WSPID.h"
+#include "SetpointRamp.h"
+#include "SmithPredictor.h"
+#include "PlantEstimator.h"
+#include "RelayAutotune.h"
 #include "TempController.h"
 CTempController g_tempController;
 
@@ -63,7 +70,20 @@ CBeeper g_beeper;
 
 //////////////////////////////////////////////////////
 // Loop Process Timing
-static unsigned long s_previousMillis = 0L;
+#include "TaskScheduler.h"
+CTaskScheduler g_scheduler;
+CTimerWheel g_timerWheel;
+
+#include "LoopProfiler.h"
+#ifdef LOOP_PROFILER
+CLoopProfiler g_loopProfiler;
+#endif
+
+#ifdef IDLE_SLEEP
+#include "IdleSleep.h"
+CIdleSleep g_idleSleep;
+#endif
+static bool s_firstPass = true;
 
 static unsigned long s_systemSeconds = 0L;
 void printUptime(bool _colonSpace)
@@ -99,8 +119,8 @@ void setup()
 	g_beeper.setup();
 
 	// ----------------------------------------
-	// Prep the thermocouple
-	g_thermocouple.init();
+	// Prep the thermocouples
+	g_tempSensors.init();
 
 	// ----------------------------------------
 	// Prep the forced air controller
@@ -114,6 +134,13 @@ void setup()
 	// Prep the temperature controller
 	g_tempController.setup();
 
+	// ----------------------------------------
+	// Wake from idle on the inputs. They have
+	// been set up by the controllers above.
+#ifdef IDLE_SLEEP
+	g_idleSleep.setup();
+#endif
+
 	// ----------------------------------------
 	// Prep the LCD
 	g_lcd.begin(16, 2);
@@ -141,6 +168,123 @@ void setup()
 	}
 }
 
+//////////////////////////////////////////////////////
+// Scheduled tasks
+static void taskSensors()
+{
+	PROFILE_SCOPE(profile_sensors);
+	g_tempSensors.processFast();
+}
+
+static void taskPID()
+{
+	PROFILE_SCOPE(profile_pid);
+	g_tempController.processFast();
+}
+
+static void taskButtons()
+{
+	PROFILE_SCOPE(profile_buttons);
+	g_screenController.processFast();
+}
+
+static void taskBeeper()
+{
+	PROFILE_SCOPE(profile_beeper);
+	g_beeper.processFast();
+}
+
+static void taskDisplay()
+{
+	PROFILE_SCOPE(profile_display);
+	g_screenController.processDisplay();
+}
+
+static void taskOneSecond()
+{
+	// Uptime is wall time, so it also counts ticks too far
+	// behind to be made up
+	s_systemSeconds += 1 + g_scheduler.lastSkipped();
+
+#ifdef SERIAL_LOG
+	if(g_scheduler.lastSkipped())
+	{
+		printUptime();
+		Serial.print(F("Skipped one-second ticks: "));
+		Serial.println(g_scheduler.lastSkipped());
+	}
+#endif
+
+	// ----------------------------------------
+	// Run the stove simulator
+#ifdef SIMULATION_MODE
+	{
+		PROFILE_SCOPE(profile_stoveSim);
+		g_stoveSim.processOneSecond();
+	}
+#endif
+
+	// ----------------------------------------
+	// Sensor health
+	{
+		PROFILE_SCOPE(profile_sensorHealth);
+		g_tempSensors.processOneSecond();
+	}
+
+	// ----------------------------------------
+	// Run the fan controller
+	{
+		PROFILE_SCOPE(profile_fan);
+		g_fanController.processOneSecond();
+	}
+
+	// ----------------------------------------
+	// Run the temperature controller state machine
+	{
+		PROFILE_SCOPE(profile_stateMachine);
+		g_tempController.processOneSecond();
+	}
+
+	// ----------------------------------------
+	// Task overruns
+	g_scheduler.processOneSecond();
+}
+
+#ifdef LOOP_PROFILER
+static void taskProfiler()
+{
+	g_loopProfiler.processDebug();
+}
+#endif
+
+static const char s_nameSensors[] PROGMEM = "sensors";
+static const char s_namePID[] PROGMEM = "pid";
+static const char s_nameButtons[] PROGMEM = "buttons";
+static const char s_nameBeeper[] PROGMEM = "beeper";
+static const char s_nameDisplay[] PROGMEM = "display";
+static const char s_nameOneSecond[] PROGMEM = "onesecond";
+#ifdef LOOP_PROFILER
+static const char s_nameProfiler[] PROGMEM = "profiler";
+#endif
+
+// In priority order, when two are due on the same pass the
+// one nearer the top runs first
+static const CSchedulerTaskT s_tasks[] =
+{
+	{ s_nameSensors,	taskSensors,	SCHED_SENSOR_PERIOD,		SCHED_SENSOR_PHASE,	SCHED_CATCH_UP_NONE,		SCHED_SENSOR_BUDGET },
+	{ s_namePID,		taskPID,		SCHED_PID_PERIOD,			SCHED_PID_PHASE,	SCHED_CATCH_UP_NONE,		SCHED_PID_BUDGET },
+	{ s_nameButtons,	taskButtons,	SCHED_BUTTON_PERIOD,		SCHED_BUTTON_PHASE,	SCHED_CATCH_UP_NONE,		SCHED_BUTTON_BUDGET },
+	{ s_nameBeeper,		taskBeeper,		SCHED_BEEPER_PERIOD,		SCHED_BEEPER_PHASE,	SCHED_CATCH_UP_NONE,		SCHED_BEEPER_BUDGET },
+	{ s_nameOneSecond,	taskOneSecond,	SCHED_ONE_SECOND_PERIOD,	SCHED_ONE_SECOND_PHASE,	SCHED_ONE_SECOND_CATCH_UP,	SCHED_ONE_SECOND_BUDGET },
+	{ s_nameDisplay,	taskDisplay,	SCHED_DISPLAY_PERIOD,		SCHED_DISPLAY_PHASE,	SCHED_CATCH_UP_NONE,		SCHED_DISPLAY_BUDGET },
+#ifdef LOOP_PROFILER
+	{ s_nameProfiler,	taskProfiler,	SCHED_PROFILER_PERIOD,		SCHED_PROFILER_PHASE,	SCHED_CATCH_UP_NONE,		SCHED_PROFILER_BUDGET },
+#endif
+};
+
+#define SCHED_TASK_COUNT	(sizeof(s_tasks) / sizeof(s_tasks[0]))
+static CSchedulerTaskStateT s_taskStates[SCHED_TASK_COUNT];
+
 //////////////////////////////////////////////////////
 // Arduino loop function called over and over forever
 void loop()
@@ -148,10 +292,12 @@ void loop()
 	// ----------------------------------------
 	// Set initial screen. From there it's up to
 	// the screen objects
-	if(s_previousMillis == 0L)
+	if(s_firstPass)
 	{
-		s_previousMillis = millis();
+		s_firstPass = false;
 		g_screenController.setScreen(SCREEN_ID_NORMAL);
+		g_timerWheel.start(millis());
+		g_scheduler.start(s_tasks, s_taskStates, SCHED_TASK_COUNT, millis());
 
 #ifdef SERIAL_PLOT
 		Serial.print(F("Call, Target, Actual, PWM"));
@@ -162,45 +308,46 @@ void loop()
 #endif
 	}
 
-	// ----------------------------------------
-	// Fast Processing
-	g_screenController.processFast();
-	g_forcedDraftMotor.processFast();
-	g_tempController.processFast();
-	g_beeper.processFast();
-
-	// ----------------------------------------
-	// One-second processing
-	unsigned long currentMillis = millis();
-	if( currentMillis - s_previousMillis >= ONE_SECOND_MS )
+	bool ran;
 	{
-		// Time handling
-		s_previousMillis = currentMillis;
-		s_systemSeconds++;
+		PROFILE_SCOPE(profile_loop);
 
 		// ----------------------------------------
-		// Run the stove simulator
-#ifdef SIMULATION_MODE
-		g_stoveSim.processOneSecond();
-#endif
+		// The one clock read for the pass. Timers expire
+		// first, so the task sees them as of now.
+		unsigned long now = millis();
+		g_timerWheel.advance(now);
 
 		// ----------------------------------------
-		// Update the display
-		g_screenController.processOneSecond();
-
-		// ----------------------------------------
-		// Run the fan controller
-		g_fanController.processOneSecond();
+		// An input changed while we slept. The mute and
+		// blast buttons are read by the PID task, so run
+		// it now. The thermostat inputs are read on the
+		// next one-second tick.
+#ifdef IDLE_SLEEP
+		uint32_t changeMicros;
+		if(g_idleSleep.inputChanged(changeMicros))
+		{
+			g_scheduler.trigger(taskPID);
+			PROFILE_RECORD(profile_wake, micros() - changeMicros);
+		}
+#endif
 
 		// ----------------------------------------
-		// Run the temperature controller state machine
-		g_tempController.processOneSecond();
+		// One task per pass, whichever is due first
+		ran = g_scheduler.runNext(now);
+	}
 
-#ifdef DEBUG_INO
-		Serial.print(F("One-second processing took: "));
-		Serial.println(millis() - currentMillis);
-#endif
+	// ----------------------------------------
+	// Nothing was due, idle until the next interrupt
+#ifdef IDLE_SLEEP
+	if(!ran)
+	{
+		uint32_t slept = g_idleSleep.sleep();
+		PROFILE_RECORD(profile_sleep, slept);
 	}
+#else
+	UNUSED(ran);
+#endif
 }
 
 //////////////////////////////////////////////////////
@@ -0,0 +1,119 @@
+////////////////////////////////////////////////////////////
+// A MAX6675 on the stub's pins, for the host tests. It
+// watches CS and SCK through g_stubPinHook and drives SO the
+// way the chip does, so the sketch's real bus code clocks
+// the frames out of it.
+////////////////////////////////////////////////////////////
+#ifndef Max6675Sim_h
+#define Max6675Sim_h
+
+#include <Arduino.h>
+
+#include "Pins.h"
+
+#define MAX6675_CONVERSION_MS	(220UL)		// Datasheet maximum
+
+class CMax6675Sim
+{
+protected:
+	static CMax6675Sim *s_sim;
+
+	int m_csPin;
+	unsigned int m_shift;		// What's left of the frame being clocked out
+	int m_frameEdges;			// SCK rising edges since CS went low
+	unsigned long m_conversionStart;
+
+	static void pinHook(int _pin, int _value)
+	{
+		if(s_sim)
+			s_sim->pinChanged(_pin, _value);
+	}
+
+	void putBit()
+	{
+		g_stubPins[PIN_THERMOCOUPLE_SO] = (m_shift & 0x8000) ? HIGH : LOW;
+	}
+
+	void pinChanged(int _pin, int _value)
+	{
+		if(_pin == m_csPin)
+		{
+			if(_value == LOW)
+			{
+				// Stops the conversion, D15 is out at once
+				if((millis() - m_conversionStart) < MAX6675_CONVERSION_MS)
+					m_earlyReads++;
+				m_shift = m_frame;
+				m_frameEdges = 0;
+				m_lastReadTime = millis();
+				putBit();
+			}
+			else
+			{
+				// Starts the next conversion
+				m_frames++;
+				if(m_frameEdges != THERMOCOUPLE_FRAME_BITS)
+					m_badFrames++;
+				if(g_stubPins[PIN_THERMOCOUPLE_SCK] != LOW)
+					m_badFrames++;
+				m_conversionStart = millis();
+			}
+		}
+		else if(_pin == PIN_THERMOCOUPLE_SCK)
+		{
+			if(g_stubPins[m_csPin] != LOW)
+			{
+				m_strayEdges++;
+				return;
+			}
+
+			// The rest of the bits come out on the falling edges
+			if(_value == HIGH)
+				m_frameEdges++;
+			else
+			{
+				m_shift <<= 1;
+				putBit();
+			}
+		}
+	}
+
+public:
+	unsigned int m_frame;		// What the next read clocks out
+	unsigned long m_frames;		// CS low then high again
+	unsigned long m_badFrames;	// Not 16 clocks, or SCK left high
+	unsigned long m_strayEdges;	// SCK moved while CS was high
+	unsigned long m_earlyReads;	// CS went low mid conversion
+	unsigned long m_lastReadTime;
+
+	CMax6675Sim(int _csPin)
+	{
+		m_csPin = _csPin;
+		m_shift = 0;
+		m_frameEdges = 0;
+		m_conversionStart = millis();
+
+		m_frame = 0;
+		m_frames = 0;
+		m_badFrames = 0;
+		m_strayEdges = 0;
+		m_earlyReads = 0;
+		m_lastReadTime = 0;
+
+		// CS idles high
+		g_stubPins[m_csPin] = HIGH;
+
+		s_sim = this;
+		g_stubPinHook = pinHook;
+	}
+
+	~CMax6675Sim()
+	{
+		s_sim = 0;
+		g_stubPinHook = 0;
+	}
+};
+
+CMax6675Sim *CMax6675Sim::s_sim = 0;
+
+#endif
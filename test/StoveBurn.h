@@ -0,0 +1,99 @@
+////////////////////////////////////////////////////////////
+// The simulated burn the closed loop tests share: CStoveSim
+// under the flue PID, set up the way CTempController does it
+////////////////////////////////////////////////////////////
+#ifndef StoveBurn_h
+#define StoveBurn_h
+
+#include "WSPID.h"
+#include "StoveSim.h"
+
+// 30 minutes at the idle setpoint, the run setpoint until the
+// third hour, then idle again. Seconds and degrees F.
+#define BURN_LENGTH			(4L * 3600)
+#define BURN_RUN_START		(1800L)
+#define BURN_RUN_END		(3L * 3600)
+#define BURN_IDLE_TEMP		(150)
+#define BURN_RUN_TEMP		(350)
+
+// A CStoveSim the tests can upset (a log collapsing, the door opening)
+class CBurnSim : public CStoveSim
+{
+public:
+	void kick(double _degrees) { m_curTemp += _degrees; }
+};
+
+////////////////////////////////////////////////////////////
+// What each run is judged on. IAE is against the final target
+// from BURN_RUN_START on, the peak is while running, and fuel
+// is counted from BURN_RUN_START.
+////////////////////////////////////////////////////////////
+class CBurnStats
+{
+public:
+	long m_totalVariation;	// Sum of blower PWM changes, counts
+	double m_iae;			// Degree seconds
+	int m_peak;				// Degrees F
+	double m_fuel;			// Oz
+
+	int m_lastOutput;
+	double m_startFuel;
+
+	CBurnStats()
+	{
+		m_totalVariation = 0;
+		m_iae = 0.;
+		m_peak = 0;
+		m_fuel = 0.;
+		m_lastOutput = 0;
+		m_startFuel = 0.;
+	}
+
+	void process(long _t, CStoveSim &_sim, int _output)
+	{
+		int temp = _sim.getTemperature();
+
+		if(_t > 0)
+			m_totalVariation += abs(_output - m_lastOutput);
+		m_lastOutput = _output;
+
+		if(_t == BURN_RUN_START)
+			m_startFuel = _sim.getFuelLoad();
+		if(_t >= BURN_RUN_START)
+		{
+			m_iae += abs(temp - ((_t < BURN_RUN_END) ? BURN_RUN_TEMP : BURN_IDLE_TEMP));
+			if(_t < BURN_RUN_END)
+				m_peak = max(m_peak, temp);
+			m_fuel = m_startFuel - _sim.getFuelLoad();
+		}
+	}
+
+	void print(const char *_name)
+	{
+		printf("%-28s TV %5" PRId32 "  IAE %6.0f  peak %3d  fuel %5.1f oz\n", _name, (int32_t)m_totalVariation, m_iae, m_peak, m_fuel);
+	}
+};
+
+// The single loop flue PID from CTempController's constructor
+inline void setupFluePid(CWSPID &_pid, double _kp, double _ki, double _kd)
+{
+	_pid.SetSampleTime(ONE_SECOND_MS);
+	_pid.SetScale(FLUE_PID_SCALE);
+	_pid.SetOutputLimits(PWM_MOTOR_STOP, PWM_MOTOR_MAX_COMMAND);
+	_pid.SetDeadZone(PWM_MOTOR_MIN_COMMAND, FLUE_PID_TRACKING_TIME);
+	_pid.SetDerivativeFilter(FLUE_PID_D_FILTER_TIME);
+	_pid.SetFeedforwardDecay(FLUE_FF_DECAY_TIME);
+	_pid.SetTunings(_kp, _ki, _kd);
+	_pid.SetMode(AUTOMATIC);
+	_pid.SetSetpoint(BURN_IDLE_TEMP);
+}
+
+// What CPWMMotor does with a command below the one that keeps it turning
+inline int blowerCommand(int _output)
+{
+	if((_output > PWM_MOTOR_STOP) && (_output < PWM_MOTOR_MIN_COMMAND))
+		return PWM_MOTOR_MIN_COMMAND;
+	return _output;
+}
+
+#endif
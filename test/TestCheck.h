@@ -0,0 +1,45 @@
+////////////////////////////////////////////////////////////
+// Minimal checks for the host tests. Each test is its own
+// program, main() returns testResult().
+////////////////////////////////////////////////////////////
+#ifndef TestCheck_h
+#define TestCheck_h
+
+#include <stdio.h>
+#include <inttypes.h>
+
+static int s_testChecks = 0;
+static int s_testFailures = 0;
+
+#define TEST_CHECK(_cond)		testCheck((_cond), #_cond, __FILE__, __LINE__)
+#define TEST_EQUAL(_a, _b)		testEqual((int64_t)(_a), (int64_t)(_b), #_a, #_b, __FILE__, __LINE__)
+
+inline bool testCheck(bool _ok, const char *_text, const char *_file, int _line)
+{
+	s_testChecks++;
+	if(!_ok)
+	{
+		s_testFailures++;
+		printf("%s:%d: FAILED: %s\n", _file, _line, _text);
+	}
+	return _ok;
+}
+
+inline bool testEqual(int64_t _a, int64_t _b, const char *_aText, const char *_bText, const char *_file, int _line)
+{
+	s_testChecks++;
+	if(_a != _b)
+	{
+		s_testFailures++;
+		printf("%s:%d: FAILED: %s == %s (%" PRId64 " != %" PRId64 ")\n", _file, _line, _aText, _bText, _a, _b);
+	}
+	return _a == _b;
+}
+
+inline int testResult(const char *_name)
+{
+	printf("%s: %d checks, %d failed\n", _name, s_testChecks, s_testFailures);
+	return s_testFailures ? 1 : 0;
+}
+
+#endif
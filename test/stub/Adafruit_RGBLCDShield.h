@@ -0,0 +1,37 @@
+////////////////////////////////////////////////////////////
+// Host stub for the LCD shield. The buttons read back
+// g_stubButtons, everything else does nothing.
+////////////////////////////////////////////////////////////
+#ifndef Adafruit_RGBLCDShield_h
+#define Adafruit_RGBLCDShield_h
+
+#include <Arduino.h>
+
+#define BUTTON_UP		(0x08)
+#define BUTTON_DOWN		(0x04)
+#define BUTTON_LEFT		(0x10)
+#define BUTTON_RIGHT	(0x02)
+#define BUTTON_SELECT	(0x01)
+
+extern uint8_t g_stubButtons;
+
+class Adafruit_RGBLCDShield
+{
+public:
+	void begin(int _cols, int _rows) { (void)_cols; (void)_rows; }
+	void setBacklight(int _color) { (void)_color; }
+	void createChar(int _location, unsigned char *_map) { (void)_location; (void)_map; }
+	void setCursor(int _col, int _row) { (void)_col; (void)_row; }
+	template <class T> size_t print(T) { return 0; }
+	template <class T> size_t print(T, int) { return 0; }
+	void clear() {}
+	void blink() {}
+	void noBlink() {}
+	void cursor() {}
+	void noCursor() {}
+	void display() {}
+	void noDisplay() {}
+	uint8_t readButtons() { return g_stubButtons; }
+};
+
+#endif
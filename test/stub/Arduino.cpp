@@ -0,0 +1,24 @@
+////////////////////////////////////////////////////////////
+// Globals behind the host Arduino stub
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+#include <avr/sleep.h>
+
+uint32_t g_stubMillis = 0;
+uint32_t g_stubMicros = 0;
+int g_stubPins[STUB_PIN_COUNT];
+StubPinHookT g_stubPinHook = 0;
+volatile uint8_t g_stubPCICR = 0;
+volatile uint8_t g_stubPCMSK[3];
+HardwareSerial Serial;
+
+StubSleepHookT g_stubSleepHook = 0;
+int g_stubSleepMode = -1;
+bool g_stubSleepEnabled = false;
+uint32_t g_stubSleeps = 0;
+
+// The sketch defines this in WoodFurnace.ino
+void printUptime(bool _colonSpace)
+{
+	(void)_colonSpace;
+}
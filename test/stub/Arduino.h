@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////
+// Just enough of the Arduino core to run the sketch's
+// classes on the host. The clock and the pins are globals
+// the tests drive directly.
+////////////////////////////////////////////////////////////
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <inttypes.h>
+
+typedef uint8_t byte;
+
+#define HIGH			(1)
+#define LOW				(0)
+#define INPUT			(0)
+#define OUTPUT			(1)
+#define INPUT_PULLUP	(2)
+
+#define A0	(14)
+#define A1	(15)
+#define A2	(16)
+#define A3	(17)
+#define A4	(18)
+#define A5	(19)
+#define A6	(20)
+#define A7	(21)
+
+#define STUB_PIN_COUNT	(32)
+
+#define PROGMEM
+class __FlashStringHelper;
+#define F(x) (reinterpret_cast<const __FlashStringHelper *>(x))
+
+// Macros like the real core, so mixed types work the same way
+#define min(a, b)	((a) < (b) ? (a) : (b))
+#define max(a, b)	((a) > (b) ? (a) : (b))
+#define constrain(a, l, h) ((a) < (l) ? (l) : ((a) > (h) ? (h) : (a)))
+
+// The clock, in ms. micros() runs off the same count plus
+// g_stubMicros so sub-millisecond steps can be tested too.
+// Both are 32 bits and roll over like the AVR's. The host's
+// long is 64 bits, which is why the sketch's code under test
+// uses int32_t and uint32_t rather than long.
+extern uint32_t g_stubMillis;
+extern uint32_t g_stubMicros;
+inline uint32_t millis() { return g_stubMillis; }
+inline uint32_t micros() { return g_stubMillis * (uint32_t)1000 + g_stubMicros; }
+inline void delay(uint32_t _ms) { g_stubMillis += _ms; }
+inline void delayMicroseconds(unsigned int _us) { (void)_us; }
+
+// Pins read back whatever was last written (or set by a test).
+// A test can hang a device model off the writes with g_stubPinHook.
+typedef void (*StubPinHookT)(int _pin, int _value);
+extern int g_stubPins[STUB_PIN_COUNT];
+extern StubPinHookT g_stubPinHook;
+inline void pinMode(int _pin, int _mode) { if(_mode == INPUT_PULLUP) g_stubPins[_pin] = HIGH; }
+inline void digitalWrite(int _pin, int _value)
+{
+	int old = g_stubPins[_pin];
+	g_stubPins[_pin] = _value;
+	if(g_stubPinHook && (old != _value))
+		g_stubPinHook(_pin, _value);
+}
+inline int digitalRead(int _pin) { return g_stubPins[_pin]; }
+inline void analogWrite(int _pin, int _value) { g_stubPins[_pin] = _value; }
+inline int analogRead(int _pin) { return g_stubPins[_pin]; }
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+// The pin-change registers, laid out like an Uno's: port B
+// (pins 8-13) on PCINT0, port C (A0-A5) on PCINT1, port D
+// (0-7) on PCINT2. A test calls an ISR() by its vector name
+// to fire it.
+#define _BV(_bit)		(1 << (_bit))
+#define ISR(_vector)	void _vector()
+extern volatile uint8_t g_stubPCICR;
+extern volatile uint8_t g_stubPCMSK[3];
+inline int stubPinToPCINT(int _pin) { return (_pin < 8) ? 2 : ((_pin < 14) ? 0 : ((_pin < 20) ? 1 : -1)); }
+#define digitalPinToPCICR(_pin)		((stubPinToPCINT(_pin) >= 0) ? &g_stubPCICR : (volatile uint8_t *)0)
+#define digitalPinToPCICRbit(_pin)	(stubPinToPCINT(_pin))
+#define digitalPinToPCMSK(_pin)		((stubPinToPCINT(_pin) >= 0) ? &g_stubPCMSK[stubPinToPCINT(_pin)] : (volatile uint8_t *)0)
+#define digitalPinToPCMSKbit(_pin)	((_pin) < 8 ? (_pin) : ((_pin) < 14 ? (_pin) - 8 : (_pin) - 14))
+
+// Swallows everything
+struct HardwareSerial
+{
+	void begin(long _baud) { (void)_baud; }
+	template <class T> size_t print(T) { return 0; }
+	template <class T> size_t print(T, int) { return 0; }
+	template <class T> size_t println(T) { return 0; }
+	template <class T> size_t println(T, int) { return 0; }
+	size_t println() { return 0; }
+	int available() { return 0; }
+	int read() { return -1; }
+};
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,4 @@
+// Host stub, the LCD shield stub doesn't need the bus
+#ifndef Wire_h
+#define Wire_h
+#endif
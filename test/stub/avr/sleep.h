@@ -0,0 +1,31 @@
+////////////////////////////////////////////////////////////
+// avr/sleep.h for the host tests. sleep_cpu() hands the
+// time asleep to g_stubSleepHook, which moves the clock to
+// whatever interrupt ends it.
+////////////////////////////////////////////////////////////
+#ifndef avr_sleep_h
+#define avr_sleep_h
+
+#include <Arduino.h>
+
+#define SLEEP_MODE_IDLE		(0)
+
+typedef void (*StubSleepHookT)();
+extern StubSleepHookT g_stubSleepHook;
+extern int g_stubSleepMode;
+extern bool g_stubSleepEnabled;
+extern uint32_t g_stubSleeps;		// sleep_cpu() with sleep enabled
+
+inline void set_sleep_mode(int _mode) { g_stubSleepMode = _mode; }
+inline void sleep_enable() { g_stubSleepEnabled = true; }
+inline void sleep_disable() { g_stubSleepEnabled = false; }
+inline void sleep_cpu()
+{
+	if(!g_stubSleepEnabled)
+		return;
+	g_stubSleeps++;
+	if(g_stubSleepHook)
+		g_stubSleepHook();
+}
+
+#endif
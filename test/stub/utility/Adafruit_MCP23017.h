@@ -0,0 +1,4 @@
+// Host stub, see Adafruit_RGBLCDShield.h
+#ifndef Adafruit_MCP23017_h
+#define Adafruit_MCP23017_h
+#endif
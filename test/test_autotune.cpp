@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////
+// CRelayAutotune against the stove simulator, the way
+// CTempController runs it: from idle and from running, with
+// the relay's blower commands going through the motor's
+// minimum. The gains it suggests then have to hold the burn.
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+
+#include "RelayAutotune.h"
+#include "StoveBurn.h"
+#include "TestCheck.h"
+
+// What a sane suggestion looks like, in settings units (before
+// FLUE_PID_SCALE). The stove's dead time is about 30 s.
+#define SANE_PU_MIN		(60.)		// Seconds
+#define SANE_PU_MAX		(1200.)
+#define SANE_KP_MIN		(0.5)
+#define SANE_KP_MAX		(50.)
+
+// Settled means the last 10 minutes of each phase stay this close
+#define SETTLE_WINDOW	(600L)
+#define SETTLE_ERROR	(10)		// Degrees F
+
+class CTuneBurn : public CBurnStats
+{
+public:
+	int m_idleError;	// Worst error in the last SETTLE_WINDOW of idle
+	int m_runError;		// ...and of running
+
+	CTuneBurn() { m_idleError = m_runError = 0; }
+};
+
+// Runs the relay at _setpoint, starting from a stove the PID has
+// been holding there, and returns the suggestion in settings units
+static bool autotune(int _setpoint, double &_kp, double &_ki, double &_kd)
+{
+	CWSPID pid;
+	setupFluePid(pid, 3.27, 0.09, 6.00);
+	pid.SetSetpoint(_setpoint);
+
+	CBurnSim sim;
+	sim.bumpToMinForcedDraftTemp();
+
+	// Settle on the PID first, the controller only tunes from idle
+	// or running, and the relay is centered on what the blower
+	// was doing
+	int32_t t = 0;
+	int output = PWM_MOTOR_STOP;
+	for(; t < BURN_RUN_START; t++)
+	{
+		g_stubMillis = t * ONE_SECOND_MS;
+		sim.processOneSecond();
+		output = blowerCommand(pid.Compute((int32_t)sim.getTemperature() * WSPID_FIXED_ONE, sim.getSampleSequence(), sim.getSampleTime()));
+		sim.setForcedDraftBlower(output);
+	}
+
+	CRelayAutotune tune;
+	tune.start(_setpoint, output);
+
+	int32_t started = t;
+	int lowest = 32767;
+	while(tune.getState() == CRelayAutotune::state_running)
+	{
+		g_stubMillis = t++ * ONE_SECOND_MS;
+		sim.processOneSecond();
+		lowest = min(lowest, sim.getTemperature());
+		sim.setForcedDraftBlower(blowerCommand(tune.processOneSecond(sim.getTemperature())));
+	}
+
+	_kp = tune.getKp() / FLUE_PID_SCALE;
+	_ki = tune.getKi() / FLUE_PID_SCALE;
+	_kd = tune.getKd() / FLUE_PID_SCALE;
+
+	printf("autotune at %3d F from %3d: %4" PRId32 " s, Ku %5.2f Pu %5.1f s -> Kp %5.2f Ki %5.3f Kd %4.2f\n",
+		_setpoint, output, t - started, tune.getKu(), tune.getPu(), _kp, _ki, _kd);
+
+	TEST_EQUAL(tune.getState(), CRelayAutotune::state_done);
+	TEST_EQUAL(tune.getOutput(), output);
+
+	// The fire never dropped out from under it, and it finished
+	// well before giving up
+	TEST_CHECK(lowest >= MIN_FORCED_DRAFT_TEMP);
+	TEST_CHECK(t - started < AUTOTUNE_MAX_TIME / 2);
+
+	TEST_CHECK((tune.getPu() >= SANE_PU_MIN) && (tune.getPu() <= SANE_PU_MAX));
+	TEST_CHECK((_kp >= SANE_KP_MIN) && (_kp <= SANE_KP_MAX));
+	TEST_CHECK(_ki > 0.);
+	TEST_CHECK(_kd == 0.);
+
+	return tune.getState() == CRelayAutotune::state_done;
+}
+
+// The usual burn on the suggested gains
+static CTuneBurn burn(double _kp, double _ki, double _kd)
+{
+	CWSPID pid;
+	setupFluePid(pid, _kp, _ki, _kd);
+
+	// The PID can hold them without clamping
+	TEST_CHECK(!pid.GetTuningsClamped());
+
+	CBurnSim sim;
+	sim.bumpToMinForcedDraftTemp();
+
+	CTuneBurn stats;
+	for(int32_t t = 0; t < BURN_LENGTH; t++)
+	{
+		g_stubMillis = t * ONE_SECOND_MS;
+		if(t == BURN_RUN_START)
+			pid.SetSetpoint(BURN_RUN_TEMP);
+		if(t == BURN_RUN_END)
+			pid.SetSetpoint(BURN_IDLE_TEMP);
+
+		sim.processOneSecond();
+		int temp = sim.getTemperature();
+		int output = blowerCommand(pid.Compute((int32_t)temp * WSPID_FIXED_ONE, sim.getSampleSequence(), sim.getSampleTime()));
+		sim.setForcedDraftBlower(output);
+		stats.process(t, sim, output);
+
+		if((t >= BURN_RUN_START - SETTLE_WINDOW) && (t < BURN_RUN_START))
+			stats.m_idleError = max(stats.m_idleError, abs(temp - BURN_IDLE_TEMP));
+		if((t >= BURN_RUN_END - SETTLE_WINDOW) && (t < BURN_RUN_END))
+			stats.m_runError = max(stats.m_runError, abs(temp - BURN_RUN_TEMP));
+	}
+	return stats;
+}
+
+int main()
+{
+	// The hand tuned gains the other tests use
+	CTuneBurn handTuned = burn(3.27, 0.09, 6.00);
+	handTuned.print("burn on hand tuned gains");
+
+	int setpoints[] = { BURN_IDLE_TEMP, BURN_RUN_TEMP };
+
+	for(unsigned int s = 0; s < sizeof(setpoints) / sizeof(setpoints[0]); ++s)
+	{
+		double kp, ki, kd;
+		if(!autotune(setpoints[s], kp, ki, kd))
+			continue;
+
+		CTuneBurn tuned = burn(kp, ki, kd);
+		tuned.print("  burn on those gains");
+		printf("%-28s settled idle +/-%d F, run +/-%d F\n", "", tuned.m_idleError, tuned.m_runError);
+
+		TEST_CHECK(tuned.m_idleError <= SETTLE_ERROR);
+		TEST_CHECK(tuned.m_runError <= SETTLE_ERROR);
+		TEST_CHECK(tuned.m_peak <= BURN_RUN_TEMP + 50);
+
+		// No more work for the blower than the hand tuned gains
+		// give it, give or take
+		TEST_CHECK(tuned.m_totalVariation < 2 * handTuned.m_totalVariation);
+	}
+
+	return testResult("test_autotune");
+}
@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////
+// CButtonController debounce and hold times across the
+// millis() rollover
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include <Wire.h>
+#include <Adafruit_RGBLCDShield.h>
+#include <utility/Adafruit_MCP23017.h>
+
+#include "Pins.h"
+#include "Defs.h"
+#include "ScreenController.h"
+
+#include "TestCheck.h"
+
+Adafruit_RGBLCDShield g_lcd;
+uint8_t g_stubButtons = 0;
+
+// The scheduler's button rate
+#define POLL_MS		(20L)
+
+static void runFor(CButtonController &_buttons, uint32_t _ms)
+{
+	for(uint32_t _ = 0; _ < _ms; _ += POLL_MS)
+	{
+		g_stubMillis += POLL_MS;
+		_buttons.processFast();
+	}
+}
+
+// Press at _start, hold for 2 s, release
+static void pressAndHold(uint32_t _start)
+{
+	CButtonController buttons;
+
+	g_stubMillis = _start;
+	g_stubButtons = 0;
+	buttons.processFast();
+	runFor(buttons, 100);
+	TEST_CHECK(!buttons.anyButtonsPressed());
+
+	// Debounced within two polls, then counting up
+	g_stubButtons = BUTTON_SELECT;
+	runFor(buttons, 2 * POLL_MS);
+	TEST_CHECK(buttons.anyButtonsPressed());
+	uint32_t held = buttons.getButton(BC_BUTTON_SELECT);
+	TEST_CHECK(held <= 2 * POLL_MS);
+
+	runFor(buttons, 2000);
+	held = buttons.getButton(BC_BUTTON_SELECT);
+	TEST_CHECK((held >= 2000) && (held <= 2000 + 2 * POLL_MS));
+	TEST_EQUAL(buttons.getButton(BC_BUTTON_UP), 0);
+
+	// Released
+	g_stubButtons = 0;
+	runFor(buttons, 2 * POLL_MS);
+	TEST_CHECK(!buttons.anyButtonsPressed());
+	TEST_EQUAL(buttons.getButton(BC_BUTTON_SELECT), 0);
+}
+
+int main()
+{
+	// Well away from the rollover, then pressed just before it,
+	// held across it, and every phase around millis() == 0
+	pressAndHold(1000);
+	pressAndHold(0xFFFFFFFFUL - 1000);
+	for(uint32_t offset = 0; offset < 200; ++offset)
+		pressAndHold(0xFFFFFFFFUL - 160 - offset);
+
+	// The debounce wait itself straddles the rollover
+	{
+		CButtonController buttons;
+
+		g_stubMillis = 0xFFFFFFFFUL - 4;
+		g_stubButtons = BUTTON_UP;
+		buttons.processFast();
+
+		// 5 ms later (past the rollover), still inside the debounce
+		g_stubMillis += 5;
+		buttons.processFast();
+		TEST_CHECK(!buttons.anyButtonsPressed());
+
+		g_stubMillis += BC_DEBOUNCE_DELAY;
+		buttons.processFast();
+		TEST_CHECK(buttons.anyButtonsPressed());
+	}
+
+	return testResult("test_buttons");
+}
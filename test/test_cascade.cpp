@@ -0,0 +1,186 @@
+////////////////////////////////////////////////////////////
+// Cascade control on the simulated burn, wired the way
+// CTempController::processFast() wires it: the flue loop sets
+// the firebox setpoint, the firebox loop drives the blower.
+// Compared against the single flue loop, through a 60F drop
+// and a 60F jump in the fire while running, and with and
+// without the flue loop's anti-windup through a fire that is
+// smothered for 5 minutes.
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+
+#include "SetpointRamp.h"
+#include "StoveBurn.h"
+#include "TestCheck.h"
+
+#define UPSET_DROP_TIME		(6000L)
+#define UPSET_JUMP_TIME		(8000L)
+#define UPSET_END_TIME		(9800L)
+#define UPSET_SIZE			(60.)
+
+// More heat lost than the blower can make up, so it sits at full
+#define SMOTHER_TIME		(300L)
+#define SMOTHER_RATE		(10.)	// Degrees F per second
+
+// Flue gains from Defs.h's notes on FLUE_CONTROL_CASCADE, as they
+// are entered on the setup screen (FLUE_PID_SCALE applies)
+#define CASCADE_FLUE_KP		(5.0)
+#define CASCADE_FLUE_KI		(0.2)
+
+class CCascadeBurn : public CBurnStats
+{
+public:
+	int m_upsetPeak;	// Degrees F, from the upset to the end of the run
+	double m_upsetIae;	// Degree seconds from the upset to UPSET_END_TIME
+
+	CCascadeBurn() { m_upsetPeak = 0; m_upsetIae = 0.; }
+};
+
+enum
+{
+	mode_single,
+	mode_cascade,
+	mode_cascadeNoTracking,
+};
+
+enum
+{
+	upset_dropAndJump,
+	upset_smother,
+};
+
+static CCascadeBurn burn(int _mode, int _upset)
+{
+	CWSPID pid;
+	CWSPID fluePid;
+	if(_mode == mode_single)
+		setupFluePid(pid, 3.27, 0.09, 6.00);
+	else
+	{
+		// CTempController's constructor and startPID()
+		fluePid.SetSampleTime(ONE_SECOND_MS);
+		fluePid.SetScale(FLUE_PID_SCALE);
+		fluePid.SetOutputLimits(FIREBOX_SETPOINT_MIN, FIREBOX_SETPOINT_MAX);
+		fluePid.SetDerivativeFilter(FLUE_PID_D_FILTER_TIME);
+		if(_mode == mode_cascade)
+			fluePid.SetTrackingTime(FIREBOX_SETPOINT_TRACKING_TIME);
+		fluePid.SetTunings(CASCADE_FLUE_KP, CASCADE_FLUE_KI, 0.);
+		fluePid.SetOutput(BURN_IDLE_TEMP);
+		fluePid.SetMode(AUTOMATIC);
+
+		pid.SetSampleTime(ONE_SECOND_MS);
+		pid.SetTunings(FIREBOX_PID_KP, FIREBOX_PID_KI, FIREBOX_PID_KD);
+		pid.SetOutputFilter(FIREBOX_PID_OUTPUT_FILTER_TIME);
+		pid.SetOutputLimits(PWM_MOTOR_STOP, PWM_MOTOR_MAX_COMMAND);
+		pid.SetDeadZone(PWM_MOTOR_MIN_COMMAND, FLUE_PID_TRACKING_TIME);
+		pid.SetDerivativeFilter(FLUE_PID_D_FILTER_TIME);
+		pid.SetMode(AUTOMATIC);
+		pid.SetSetpoint(BURN_IDLE_TEMP);
+	}
+
+	CSetpointRamp ramp;
+	ramp.jumpTo((long)BURN_IDLE_TEMP * WSPID_FIXED_ONE);
+
+	CBurnSim sim;
+	sim.bumpToMinForcedDraftTemp();
+
+	CCascadeBurn stats;
+	for(long t = 0; t < BURN_LENGTH; t++)
+	{
+		g_stubMillis = t * ONE_SECOND_MS;
+		if(t == BURN_RUN_START)
+			ramp.start(max(ramp.getSetpoint(), (long)sim.getTemperature() * WSPID_FIXED_ONE), (long)BURN_RUN_TEMP * WSPID_FIXED_ONE, SETPOINT_RAMP_RATE, false);
+		if(_upset == upset_dropAndJump)
+		{
+			if(t == UPSET_DROP_TIME)
+				sim.kick(-UPSET_SIZE);
+			if(t == UPSET_JUMP_TIME)
+				sim.kick(UPSET_SIZE);
+		}
+		else if((t >= UPSET_DROP_TIME) && (t < UPSET_DROP_TIME + SMOTHER_TIME))
+			sim.kick(-SMOTHER_RATE);
+		if(t == BURN_RUN_END)
+			ramp.jumpTo((long)BURN_IDLE_TEMP * WSPID_FIXED_ONE);
+		long setpoint = ramp.processOneSecond();
+
+		sim.processOneSecond();
+		long flue = (long)sim.getTemperature() * WSPID_FIXED_ONE;
+
+		int output;
+		if(_mode == mode_single)
+		{
+			pid.SetSetpointFixed(setpoint);
+			output = pid.Compute(flue, sim.getSampleSequence(), sim.getSampleTime());
+		}
+		else
+		{
+			int blower = pid.GetOutput();
+			if((blower <= PWM_MOTOR_STOP) || (blower >= PWM_MOTOR_MAX_COMMAND))
+				fluePid.TrackOutput(sim.getFireboxTemperature());
+			else
+				fluePid.StopTracking();
+
+			fluePid.SetSetpointFixed(setpoint);
+			pid.SetSetpoint(fluePid.Compute(flue, sim.getSampleSequence(), sim.getSampleTime()));
+			output = pid.Compute((long)sim.getFireboxTemperature() * WSPID_FIXED_ONE, sim.getSampleSequence(), sim.getSampleTime());
+		}
+
+		output = blowerCommand(output);
+		sim.setForcedDraftBlower(output);
+		stats.process(t, sim, output);
+
+		if((t >= UPSET_DROP_TIME) && (t < BURN_RUN_END))
+			stats.m_upsetPeak = max(stats.m_upsetPeak, sim.getTemperature());
+		if((t >= UPSET_DROP_TIME) && (t < UPSET_END_TIME))
+			stats.m_upsetIae += abs(sim.getTemperature() - BURN_RUN_TEMP);
+	}
+	return stats;
+}
+
+static void printBurn(const char *_name, CCascadeBurn &_burn)
+{
+	_burn.print(_name);
+	printf("%-28s upset IAE %6.0f  upset peak %3d\n", "", _burn.m_upsetIae, _burn.m_upsetPeak);
+}
+
+int main()
+{
+	// Through the drop and the jump the cascade has to at least
+	// halve the flue's error, with no worse overshoot or fuel
+	{
+		CCascadeBurn single = burn(mode_single, upset_dropAndJump);
+		CCascadeBurn cascade = burn(mode_cascade, upset_dropAndJump);
+
+		printBurn("single loop", single);
+		printBurn("cascade", cascade);
+
+		TEST_CHECK(cascade.m_upsetIae * 2 < single.m_upsetIae);
+		TEST_CHECK(cascade.m_peak <= single.m_peak);
+		TEST_CHECK(cascade.m_fuel <= single.m_fuel + 1.);
+
+		// The firebox ticks a degree at a time and the inner loop
+		// is fast, so it works the blower harder than the single
+		// loop. Without the output filter it was over 10x.
+		TEST_CHECK(cascade.m_totalVariation < 3 * single.m_totalVariation);
+	}
+
+	// While the fire is smothered the blower sits at full and the
+	// firebox can't reach what the flue loop asks for. Without
+	// tracking the flue loop winds up and the flue overshoots once
+	// the fire recovers.
+	{
+		CCascadeBurn tracking = burn(mode_cascade, upset_smother);
+		CCascadeBurn noTracking = burn(mode_cascadeNoTracking, upset_smother);
+
+		printBurn("smothered, cascade", tracking);
+		printBurn("smothered, no tracking", noTracking);
+
+		TEST_CHECK(tracking.m_upsetPeak <= BURN_RUN_TEMP + 5);
+		TEST_CHECK(tracking.m_upsetIae < noTracking.m_upsetIae);
+		TEST_CHECK(noTracking.m_upsetPeak > BURN_RUN_TEMP + 100);
+	}
+
+	return testResult("test_cascade");
+}
@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////
+// The PID's D term filter, on the simulated burn with the
+// tunings from Doc/SimulationPIDSettings.txt. The filter has
+// to cut the blower's total variation without costing IAE or
+// overshoot.
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+
+#include "StoveBurn.h"
+#include "TestCheck.h"
+
+static CBurnStats burn(double _kp, double _ki, double _kd, long _filterTime)
+{
+	CWSPID pid;
+	setupFluePid(pid, _kp, _ki, _kd);
+	pid.SetDerivativeFilter(_filterTime);
+
+	CBurnSim sim;
+	sim.bumpToMinForcedDraftTemp();
+
+	CBurnStats stats;
+	for(long t = 0; t < BURN_LENGTH; t++)
+	{
+		g_stubMillis = t * ONE_SECOND_MS;
+		if(t == BURN_RUN_START)
+			pid.SetSetpoint(BURN_RUN_TEMP);
+		if(t == BURN_RUN_END)
+			pid.SetSetpoint(BURN_IDLE_TEMP);
+
+		sim.processOneSecond();
+		int output = blowerCommand(pid.Compute((long)sim.getTemperature() * WSPID_FIXED_ONE, sim.getSampleSequence(), sim.getSampleTime()));
+		sim.setForcedDraftBlower(output);
+		stats.process(t, sim, output);
+	}
+	return stats;
+}
+
+static void compare(const char *_name, double _kp, double _ki, double _kd)
+{
+	CBurnStats raw = burn(_kp, _ki, _kd, 0);
+	CBurnStats filtered = burn(_kp, _ki, _kd, FLUE_PID_D_FILTER_TIME);
+
+	printf("%s\n", _name);
+	raw.print("  D unfiltered");
+	filtered.print("  D filtered");
+
+	// At least a fifth less blower movement, for no more than
+	// a couple percent of IAE and a degree of overshoot
+	TEST_CHECK(filtered.m_totalVariation * 5 < raw.m_totalVariation * 4);
+	TEST_CHECK(filtered.m_iae < raw.m_iae * 1.02);
+	TEST_CHECK(filtered.m_peak <= raw.m_peak + 1);
+}
+
+int main()
+{
+	compare("Kp 3.27 Ki 0.09 Kd 6.00", 3.27, 0.09, 6.00);
+	compare("Kp 3.50 Ki 0.09 Kd 2.25", 3.50, 0.09, 2.25);
+
+	return testResult("test_dfilter");
+}
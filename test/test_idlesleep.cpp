@@ -0,0 +1,259 @@
+////////////////////////////////////////////////////////////
+// CIdleSleep on its own, then driving the scheduler the way
+// loop() does with IDLE_SLEEP: sleep when nothing ran, and
+// run the PID task (it reads the mute and blast buttons) on
+// the pass after an input change. Sleeps end on the millis()
+// tick or a button press, whichever comes first.
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+#include <avr/sleep.h>
+
+#include "Pins.h"
+#include "Defs.h"
+
+#include "IdleSleep.h"
+#include "TaskScheduler.h"
+#include "TestCheck.h"
+
+#define TASK_COUNT		(6)
+#define TASK_RUN_TIME	(50L)		// us, each task pretends to take this long
+#define RUN_LENGTH		(60L * ONE_SECOND_MS)
+
+// Presses come this far apart (ms), so each is its own change
+#define PRESS_GAP_MIN	(5L)
+#define PRESS_GAP_MAX	(200L)
+
+// One millis() tick, the most a task can be late by
+#define WAKE_LATENCY_MAX	(1000L)		// us
+
+// IdleSleep.cpp's pin-change vectors
+void PCINT1_vect();
+void PCINT2_vect();
+
+static CIdleSleep s_idle;
+static CTaskScheduler s_scheduler;
+
+// The button presses, in micros()
+static uint32_t s_nextPress = 0;		// 0 for none
+static uint32_t s_pressTime = 0;
+static bool s_pressPending = false;
+static uint32_t s_presses = 0;
+static uint32_t s_seed = 1;
+
+// What the PID task saw
+static uint32_t s_pidRuns = 0;
+static uint32_t s_worstLatency = 0;
+
+static void setMicros(uint32_t _micros)
+{
+	g_stubMillis = _micros / 1000;
+	g_stubMicros = _micros % 1000;
+}
+
+static uint32_t pressGap()
+{
+	s_seed = s_seed * 1103515245UL + 12345UL;
+	return (PRESS_GAP_MIN + (s_seed >> 8) % (PRESS_GAP_MAX - PRESS_GAP_MIN)) * 1000 + (s_seed >> 4) % 1000;
+}
+
+// A mute or blast press (port D), or a thermostat input (port C)
+static void press()
+{
+	s_pressTime = micros();
+	s_pressPending = true;
+	s_presses++;
+	if(s_presses & 1)
+		PCINT2_vect();
+	else
+		PCINT1_vect();
+	s_nextPress = micros() + pressGap();
+}
+
+// Moves the clock on _us, pressing a button on the way if one is
+// due. A sleep ends at the press, a running task doesn't.
+static bool advance(uint32_t _us, bool _wake)
+{
+	uint32_t end = micros() + _us;
+	if(s_nextPress && (s_nextPress <= end))
+	{
+		setMicros(s_nextPress);
+		press();
+		if(_wake)
+			return true;
+	}
+	setMicros(end);
+	return false;
+}
+
+// Idle sleep wakes on the next millis() tick at the latest
+static void sleepToTick()
+{
+	advance(1000 - micros() % 1000, true);
+}
+
+static uint32_t s_sleepFor = 0;
+static void sleepFixed()
+{
+	g_stubMicros += s_sleepFor;
+}
+
+static void taskRun() { advance(TASK_RUN_TIME, false); }
+static void taskPID()
+{
+	s_pidRuns++;
+	if(s_pressPending)
+	{
+		s_worstLatency = max(s_worstLatency, micros() - s_pressTime);
+		s_pressPending = false;
+	}
+	taskRun();
+}
+
+// The same table as WoodFurnace.ino
+static const CSchedulerTaskT s_tasks[TASK_COUNT] =
+{
+	{ "sensors",	taskRun,	SCHED_SENSOR_PERIOD,		SCHED_SENSOR_PHASE,		SCHED_CATCH_UP_NONE,		SCHED_SENSOR_BUDGET },
+	{ "pid",		taskPID,	SCHED_PID_PERIOD,			SCHED_PID_PHASE,		SCHED_CATCH_UP_NONE,		SCHED_PID_BUDGET },
+	{ "buttons",	taskRun,	SCHED_BUTTON_PERIOD,		SCHED_BUTTON_PHASE,		SCHED_CATCH_UP_NONE,		SCHED_BUTTON_BUDGET },
+	{ "beeper",		taskRun,	SCHED_BEEPER_PERIOD,		SCHED_BEEPER_PHASE,		SCHED_CATCH_UP_NONE,		SCHED_BEEPER_BUDGET },
+	{ "onesecond",	taskRun,	SCHED_ONE_SECOND_PERIOD,	SCHED_ONE_SECOND_PHASE,	SCHED_ONE_SECOND_CATCH_UP,	SCHED_ONE_SECOND_BUDGET },
+	{ "display",	taskRun,	SCHED_DISPLAY_PERIOD,		SCHED_DISPLAY_PHASE,	SCHED_CATCH_UP_NONE,		SCHED_DISPLAY_BUDGET },
+};
+static CSchedulerTaskStateT s_states[TASK_COUNT];
+
+// Clears any change left over from the last check
+static void clearInput()
+{
+	uint32_t changeMicros;
+	s_idle.inputChanged(changeMicros);
+}
+
+int main()
+{
+	// The four inputs' pin-change interrupts, on PCINT1 and
+	// PCINT2 only
+	{
+		s_idle.setup();
+		TEST_EQUAL(g_stubPCMSK[2], _BV(PIN_FD_BLAST) | _BV(PIN_MUTE_ALARM));
+		TEST_EQUAL(g_stubPCMSK[1], _BV(PIN_CALL_FOR_FAN - A0) | _BV(PIN_CALL_FOR_HEAT - A0));
+		TEST_EQUAL(g_stubPCMSK[0], 0);
+		TEST_EQUAL(g_stubPCICR, _BV(1) | _BV(2));
+		TEST_EQUAL(g_stubSleepMode, SLEEP_MODE_IDLE);
+	}
+
+	// Nothing changed: it sleeps to the tick and says how long
+	{
+		uint32_t changeMicros;
+		TEST_CHECK(!s_idle.inputChanged(changeMicros));
+
+		setMicros(10300);
+		g_stubSleepHook = sleepToTick;
+		uint32_t sleeps = g_stubSleeps;
+		TEST_EQUAL(s_idle.sleep(), 700);
+		TEST_EQUAL(g_stubSleeps, sleeps + 1);
+		TEST_CHECK(!g_stubSleepEnabled);
+		TEST_CHECK(!s_idle.inputChanged(changeMicros));
+	}
+
+	// A press wakes it, and is reported once with its time
+	{
+		setMicros(20100);
+		s_nextPress = 20400;
+		TEST_EQUAL(s_idle.sleep(), 300);
+
+		uint32_t changeMicros = 0;
+		TEST_CHECK(s_idle.inputChanged(changeMicros));
+		TEST_EQUAL(changeMicros, 20400);
+		TEST_CHECK(!s_idle.inputChanged(changeMicros));
+		s_nextPress = 0;
+	}
+
+	// A change that came in while awake keeps it from sleeping
+	// until loop() has seen it
+	{
+		setMicros(30000);
+		PCINT1_vect();
+		uint32_t sleeps = g_stubSleeps;
+		TEST_EQUAL(s_idle.sleep(), 0);
+		TEST_EQUAL(g_stubSleeps, sleeps);
+
+		clearInput();
+		TEST_EQUAL(s_idle.sleep(), 1000);
+		TEST_EQUAL(g_stubSleeps, sleeps + 1);
+	}
+
+	// Two changes before loop() looks are one, at the first
+	{
+		setMicros(40000);
+		PCINT2_vect();
+		setMicros(40250);
+		PCINT1_vect();
+
+		uint32_t changeMicros = 0;
+		TEST_CHECK(s_idle.inputChanged(changeMicros));
+		TEST_EQUAL(changeMicros, 40000);
+		TEST_CHECK(!s_idle.inputChanged(changeMicros));
+	}
+
+	// A sleep across the micros() rollover
+	{
+		g_stubMillis = 0;
+		g_stubMicros = 0xFFFFFFFFUL - 200;
+		g_stubSleepHook = sleepFixed;
+		s_sleepFor = 500;
+		TEST_EQUAL(s_idle.sleep(), 500);
+	}
+
+	// loop() for a minute of button presses
+	{
+		setMicros(0);
+		s_presses = 0;
+		s_pressPending = false;
+		s_nextPress = pressGap();
+		g_stubSleepHook = sleepToTick;
+		s_scheduler.start(s_tasks, s_states, TASK_COUNT, millis());
+
+		uint32_t handled = 0;
+		uint32_t slept = 0;
+		while(millis() < (uint32_t)RUN_LENGTH)
+		{
+			uint32_t now = millis();
+
+			uint32_t changeMicros;
+			if(s_idle.inputChanged(changeMicros))
+			{
+				s_scheduler.trigger(taskPID);
+				handled++;
+			}
+
+			if(!s_scheduler.runNext(now))
+				slept += s_idle.sleep();
+		}
+
+		uint32_t scheduledPid = (RUN_LENGTH - 1 - SCHED_PID_PHASE) / SCHED_PID_PERIOD + 1;
+		printf("%lu presses, PID ran %lu times, worst press to PID %lu us, idle %.1f%%\n",
+			(unsigned long)s_presses, (unsigned long)s_pidRuns, (unsigned long)s_worstLatency,
+			100. * slept / ((double)RUN_LENGTH * 1000));
+
+		// Every press handled once, each with one extra PID run
+		// that didn't move its schedule
+		TEST_CHECK(s_presses > RUN_LENGTH / PRESS_GAP_MAX);
+		TEST_EQUAL(handled, s_presses);
+		TEST_EQUAL(s_pidRuns, scheduledPid + s_presses);
+		TEST_EQUAL((s_states[1].m_nextRun - SCHED_PID_PHASE) % SCHED_PID_PERIOD, 0);
+
+		// The buttons are read within a tick of the press, not the
+		// 20 ms poll, and sleeping made nothing late
+		TEST_CHECK(s_worstLatency < WAKE_LATENCY_MAX);
+		for(int _ = 0; _ < TASK_COUNT; ++_)
+		{
+			TEST_EQUAL(s_states[_].m_lateRuns, 0);
+			TEST_EQUAL(s_states[_].m_skipped, 0);
+		}
+
+		// Mostly asleep
+		TEST_CHECK(slept > (uint32_t)RUN_LENGTH * 950);
+	}
+
+	return testResult("test_idlesleep");
+}
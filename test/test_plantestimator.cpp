@@ -0,0 +1,93 @@
+////////////////////////////////////////////////////////////
+// CPlantEstimator learning CStoveSim while the flue PID runs
+// the simulated burn. The simulator's plant is a 30 s dead
+// time, a 29.5 s time constant (-1 / ln(1 - 2/60)) and 2.12 F
+// per PWM count (0.05 oz/s at 255 times 360 F/oz, over the
+// 1/30 cooling rate).
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+
+#include "PlantEstimator.h"
+#include "StoveBurn.h"
+#include "TestCheck.h"
+
+#define SIM_DEAD_TIME		(STOVE_SIM_DELAY_TIME)
+#define SIM_TIME_CONSTANT	(29.5)
+#define SIM_GAIN			(2.12)
+
+int main()
+{
+	CWSPID pid;
+	setupFluePid(pid, 3.27, 0.09, 6.00);
+
+	CBurnSim sim;
+	sim.bumpToMinForcedDraftTemp();
+
+	CPlantEstimator estimator;
+	TEST_EQUAL(estimator.getDeadTime(), 0);
+
+	int lastOutput = 0;
+	int runDeadTime = 0;
+	float runGain = 0.;
+	int settledDeadTime = 0;
+	float settledTimeConstant = 0.;
+	float settledGain = 0.;
+	for(long t = 0; t < BURN_LENGTH; t++)
+	{
+		g_stubMillis = t * ONE_SECOND_MS;
+		if(t == BURN_RUN_START)
+			pid.SetSetpoint(BURN_RUN_TEMP);
+		if(t == BURN_RUN_END)
+			pid.SetSetpoint(BURN_IDLE_TEMP);
+
+		sim.processOneSecond();
+		int temp = sim.getTemperature();
+		int output = blowerCommand(pid.Compute((long)temp * WSPID_FIXED_ONE, sim.getSampleSequence(), sim.getSampleTime()));
+
+		// The way CTempController feeds it, with the command
+		// that was applied over the last second
+		estimator.processOneSecond((long)temp * WSPID_FIXED_ONE, lastOutput);
+		sim.setForcedDraftBlower(output);
+		lastOutput = output;
+
+		if(t % 1800 == 0)
+			printf("%5" PRId32 "s  dead time %2d s  time constant %5.1f s  gain %5.2f F/count\n", (int32_t)t, estimator.getDeadTime(), estimator.getTimeConstant(), estimator.getGain());
+
+		// After the step up, and after the step back down
+		if(t == BURN_RUN_END - 1)
+		{
+			runDeadTime = estimator.getDeadTime();
+			runGain = estimator.getGain();
+		}
+		if(t == BURN_LENGTH - 1)
+		{
+			settledDeadTime = estimator.getDeadTime();
+			settledTimeConstant = estimator.getTimeConstant();
+			settledGain = estimator.getGain();
+		}
+	}
+
+	// One step up is enough to get within a candidate of the dead
+	// time and 10% of the gain, the step down pins it
+	TEST_CHECK(abs(runDeadTime - SIM_DEAD_TIME) <= PLANT_EST_DELAY_STEP);
+	TEST_CHECK(fabs(runGain - SIM_GAIN) < SIM_GAIN * 0.1);
+
+	printf("settled: dead time %d s, time constant %.1f s, gain %.2f F/count\n", settledDeadTime, settledTimeConstant, settledGain);
+	TEST_EQUAL(settledDeadTime, SIM_DEAD_TIME);
+	TEST_CHECK(fabs(settledTimeConstant - SIM_TIME_CONSTANT) < SIM_TIME_CONSTANT * 0.1);
+	TEST_CHECK(fabs(settledGain - SIM_GAIN) < SIM_GAIN * 0.1);
+
+	// Losing the data keeps what was learned
+	int finalDeadTime = estimator.getDeadTime();
+	TEST_CHECK(finalDeadTime != 0);
+	estimator.restart();
+	TEST_EQUAL(estimator.getDeadTime(), finalDeadTime);
+
+	// Forgetting doesn't
+	estimator.reset();
+	TEST_EQUAL(estimator.getDeadTime(), 0);
+
+	return testResult("test_plantestimator");
+}
@@ -0,0 +1,244 @@
+////////////////////////////////////////////////////////////
+// CTaskScheduler with the sketch's task table: periods and
+// phases, which task runs when several are due, triggers,
+// late starts and skips after a stall, run time overruns,
+// and the millis() rollover
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+
+#include "TaskScheduler.h"
+#include "TestCheck.h"
+
+#define TASK_COUNT	(6)
+
+// What each task did, and how long it pretends to take (us)
+static int s_runs[TASK_COUNT];
+static uint32_t s_lastRun[TASK_COUNT];
+static uint32_t s_runTime[TASK_COUNT];
+static int s_order[16];
+static int s_orderCount = 0;
+
+static CTaskScheduler s_scheduler;
+
+static void runTask(int _task)
+{
+	s_runs[_task]++;
+	s_lastRun[_task] = millis();
+	if(s_orderCount < 16)
+		s_order[s_orderCount++] = _task;
+
+	g_stubMicros += s_runTime[_task];
+}
+
+static void taskSensors() { runTask(0); }
+static void taskPID() { runTask(1); }
+static void taskButtons() { runTask(2); }
+static void taskBeeper() { runTask(3); }
+static void taskOneSecond() { runTask(4); }
+static void taskDisplay() { runTask(5); }
+
+// The same table as WoodFurnace.ino
+static const CSchedulerTaskT s_tasks[TASK_COUNT] =
+{
+	{ "sensors",	taskSensors,	SCHED_SENSOR_PERIOD,		SCHED_SENSOR_PHASE,		SCHED_CATCH_UP_NONE,		SCHED_SENSOR_BUDGET },
+	{ "pid",		taskPID,		SCHED_PID_PERIOD,			SCHED_PID_PHASE,		SCHED_CATCH_UP_NONE,		SCHED_PID_BUDGET },
+	{ "buttons",	taskButtons,	SCHED_BUTTON_PERIOD,		SCHED_BUTTON_PHASE,		SCHED_CATCH_UP_NONE,		SCHED_BUTTON_BUDGET },
+	{ "beeper",		taskBeeper,		SCHED_BEEPER_PERIOD,		SCHED_BEEPER_PHASE,		SCHED_CATCH_UP_NONE,		SCHED_BEEPER_BUDGET },
+	{ "onesecond",	taskOneSecond,	SCHED_ONE_SECOND_PERIOD,	SCHED_ONE_SECOND_PHASE,	SCHED_ONE_SECOND_CATCH_UP,	SCHED_ONE_SECOND_BUDGET },
+	{ "display",	taskDisplay,	SCHED_DISPLAY_PERIOD,		SCHED_DISPLAY_PHASE,	SCHED_CATCH_UP_NONE,		SCHED_DISPLAY_BUDGET },
+};
+static CSchedulerTaskStateT s_states[TASK_COUNT];
+
+static void startAt(uint32_t _now)
+{
+	for(int _ = 0; _ < TASK_COUNT; ++_)
+	{
+		s_runs[_] = 0;
+		s_lastRun[_] = 0;
+		s_runTime[_] = 0;
+	}
+	s_orderCount = 0;
+
+	g_stubMillis = _now;
+	g_stubMicros = 0;
+	s_scheduler.start(s_tasks, s_states, TASK_COUNT, _now);
+}
+
+// loop() for _ms milliseconds from now, as many passes each
+// millisecond as have something to run. Returns the most tasks
+// that were due in the same millisecond.
+static int runFor(uint32_t _ms)
+{
+	int mostPerMs = 0;
+	for(uint32_t _ = 0; _ < _ms; ++_)
+	{
+		g_stubMicros = 0;
+
+		int runs = 0;
+		while(s_scheduler.runNext(millis()))
+			runs++;
+		mostPerMs = max(mostPerMs, runs);
+
+		g_stubMillis++;
+	}
+	return mostPerMs;
+}
+
+// Runs each task should have had by _elapsed ms after start
+static int expectedRuns(int _task, uint32_t _elapsed)
+{
+	if(_elapsed < s_tasks[_task].m_phase)
+		return 0;
+	return (_elapsed - s_tasks[_task].m_phase) / s_tasks[_task].m_period + 1;
+}
+
+static void checkPeriods(uint32_t _start)
+{
+	startAt(_start);
+	runFor(60L * ONE_SECOND_MS);
+
+	for(int _ = 0; _ < TASK_COUNT; ++_)
+	{
+		TEST_EQUAL(s_runs[_], expectedRuns(_, 60L * ONE_SECOND_MS - 1));
+		TEST_EQUAL(s_states[_].m_lateRuns, 0);
+		TEST_EQUAL(s_states[_].m_skipped, 0);
+		TEST_EQUAL(s_states[_].m_overruns, 0);
+
+		// On the grid: the last run was a whole number of
+		// periods after the phase
+		TEST_EQUAL((s_lastRun[_] - _start - s_tasks[_].m_phase) % s_tasks[_].m_period, 0);
+	}
+}
+
+int main()
+{
+	// The rates the scheduler is meant to give
+	TEST_EQUAL(ONE_SECOND_MS / SCHED_SENSOR_PERIOD, 4);
+	TEST_EQUAL(SCHED_PID_PERIOD, SCHED_SENSOR_PERIOD);
+	TEST_EQUAL(ONE_SECOND_MS / SCHED_BUTTON_PERIOD, 50);
+	TEST_EQUAL(ONE_SECOND_MS / SCHED_DISPLAY_PERIOD, 2);
+	TEST_EQUAL(SCHED_ONE_SECOND_PERIOD, ONE_SECOND_MS);
+
+	// A minute of passes: every task at its period and phase, on
+	// time, well away from the rollover and straddling it
+	checkPeriods(0);
+	checkPeriods(0xFFFFFFFFUL - 30L * ONE_SECOND_MS);
+
+	// The phases keep the table's tasks from coming due together
+	{
+		startAt(0);
+		TEST_EQUAL(runFor(60L * ONE_SECOND_MS), 1);
+	}
+
+	// The PID runs right behind each sensor pass
+	{
+		startAt(0);
+		runFor(SCHED_PID_PHASE + 1);
+		TEST_EQUAL(s_runs[0], 1);
+		TEST_EQUAL(s_runs[1], 1);
+		TEST_EQUAL(s_lastRun[1] - s_lastRun[0], SCHED_PID_PHASE - SCHED_SENSOR_PHASE);
+	}
+
+	// Everything due on the same pass runs one per pass, in
+	// table order
+	{
+		startAt(0);
+		g_stubMillis = SCHED_ONE_SECOND_PHASE + 50;
+
+		s_orderCount = 0;
+		int passes = 0;
+		while(s_scheduler.runNext(millis()))
+			passes++;
+
+		TEST_EQUAL(passes, TASK_COUNT);
+		for(int _ = 0; _ < TASK_COUNT; ++_)
+			TEST_EQUAL(s_order[_], _);
+	}
+
+	// A trigger runs ahead of anything due, once, and doesn't
+	// move the task's schedule
+	{
+		startAt(0);
+		runFor(10);
+		uint32_t nextRun = s_states[1].m_nextRun;
+
+		s_orderCount = 0;
+		s_scheduler.trigger(taskPID);
+		TEST_CHECK(s_scheduler.runNext(millis()));
+		TEST_EQUAL(s_order[0], 1);
+		TEST_EQUAL(s_states[1].m_nextRun, nextRun);
+		TEST_CHECK(!s_scheduler.runNext(millis()));
+	}
+
+	// A 2.5 s stall: the sensor task runs once, late, and skips
+	// the periods it missed. The one second tick makes up the
+	// ones it missed on the next passes.
+	{
+		startAt(0);
+		runFor(5L * ONE_SECOND_MS);
+		int sensorRuns = s_runs[0];
+		int secondRuns = s_runs[4];
+
+		g_stubMillis += 2500;
+		s_orderCount = 0;
+		int passes = 0;
+		while(s_scheduler.runNext(millis()))
+			passes++;
+
+		// It was due at 5241, 6241 and 7241
+		TEST_EQUAL(s_runs[0], sensorRuns + 1);
+		TEST_EQUAL(s_runs[4], secondRuns + 3);
+		TEST_EQUAL(s_states[0].m_lateRuns, 1);
+		TEST_EQUAL(s_states[0].m_skipped, 2500 / SCHED_SENSOR_PERIOD);
+		TEST_EQUAL(s_states[4].m_skipped, 0);
+
+		// Starting late isn't running long
+		for(int _ = 0; _ < TASK_COUNT; ++_)
+			TEST_EQUAL(s_states[_].m_overruns, 0);
+
+		// And after the stall it's back on the grid
+		runFor(10L * ONE_SECOND_MS);
+		TEST_EQUAL((s_lastRun[0] - SCHED_SENSOR_PHASE) % SCHED_SENSOR_PERIOD, 0);
+		TEST_EQUAL((s_lastRun[4] - SCHED_ONE_SECOND_PHASE) % SCHED_ONE_SECOND_PERIOD, 0);
+	}
+
+	// Runs that take longer than the task's budget are overruns,
+	// ones that just make it aren't
+	{
+		startAt(0);
+		s_runTime[0] = SCHED_SENSOR_BUDGET;
+		s_runTime[5] = SCHED_DISPLAY_BUDGET + 1;
+		runFor(10L * ONE_SECOND_MS);
+
+		TEST_EQUAL(s_states[0].m_overruns, 0);
+		TEST_EQUAL(s_states[0].m_longestRun, SCHED_SENSOR_BUDGET);
+		TEST_EQUAL(s_states[5].m_overruns, s_runs[5]);
+		TEST_EQUAL(s_states[5].m_longestRun, SCHED_DISPLAY_BUDGET + 1);
+		TEST_EQUAL(s_states[1].m_overruns, 0);
+		TEST_EQUAL(s_states[1].m_longestRun, 0);
+
+		// Triggered runs are timed too
+		s_runTime[1] = SCHED_PID_BUDGET * 2;
+		s_scheduler.trigger(taskPID);
+		s_scheduler.runNext(millis());
+		TEST_EQUAL(s_states[1].m_overruns, 1);
+		TEST_EQUAL(s_states[1].m_longestRun, SCHED_PID_BUDGET * 2);
+	}
+
+	// The micros() count rolling over mid run doesn't make one
+	{
+		startAt(0);
+		runFor(SCHED_SENSOR_PHASE + 1);
+		g_stubMillis = 0xFFFFFFFFUL / 1000;
+		g_stubMicros = 0xFFFFFFFFUL - g_stubMillis * 1000 - 50;
+		s_runTime[1] = 100;
+		s_scheduler.trigger(taskPID);
+		s_scheduler.runNext(millis());
+		TEST_EQUAL(s_states[1].m_overruns, 0);
+		TEST_EQUAL(s_states[1].m_longestRun, 100);
+	}
+
+	return testResult("test_scheduler");
+}
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////
+// The sensor filter stages
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+
+#include "SensorFilter.h"
+#include "TempSensor_Thermocouple.h"
+
+#include "TestCheck.h"
+
+#define DEG(d)	THERMOCOUPLE_TO_FIXED(d)
+
+int main()
+{
+	// Median of 3 throws out a single spike
+	{
+		CMedianFilter<3> median;
+		median.reset(DEG(300));
+		TEST_EQUAL(median.process(DEG(900), ONE_SECOND_MS), DEG(300));
+		TEST_EQUAL(median.process(DEG(301), ONE_SECOND_MS), DEG(301));
+	}
+
+	// EMA moves alpha of the way there
+	{
+		CEMAFilter<THERMOCOUPLE_EMA_ALPHA> ema;
+		ema.reset(DEG(300));
+		TEST_EQUAL(ema.process(DEG(400), ONE_SECOND_MS), DEG(300) + ((DEG(100) * THERMOCOUPLE_EMA_ALPHA + 128) >> 8));
+	}
+
+	// A steady reading is reached to within a count from either side.
+	// The float path this replaced stored whole degrees, so it could
+	// stick more than a degree low.
+	{
+		int32_t reading = DEG(301) + DEG(1) / 4;
+		int32_t starts[] = { DEG(300), DEG(305) };
+
+		for(unsigned int _ = 0; _ < sizeof(starts) / sizeof(starts[0]); ++_)
+		{
+			CEMAFilter<THERMOCOUPLE_EMA_ALPHA> ema;
+			ema.reset(starts[_]);
+			int floatTemp = starts[_] / THERMOCOUPLE_FIXED_ONE;
+			for(int n = 0; n < 100; ++n)
+			{
+				ema.process(reading, ONE_SECOND_MS);
+				floatTemp = (301.25 * 0.3) + (floatTemp * (1. - 0.3));
+			}
+
+			int32_t settled = ema.process(reading, ONE_SECOND_MS);
+			printf("EMA from %3d F: Q8 settles %+" PRId32 "/256 F off, float path %+.2f F off\n",
+				(int)(starts[_] / THERMOCOUPLE_FIXED_ONE), settled - reading, floatTemp - 301.25);
+			TEST_CHECK(labs(settled - reading) <= 1);
+		}
+	}
+
+	// Slew limit, per second of dt
+	{
+		CSlewLimiter<THERMOCOUPLE_SLEW_LIMIT> slew;
+
+		slew.reset(DEG(300));
+		TEST_EQUAL(slew.process(DEG(400), ONE_SECOND_MS), DEG(325));
+		TEST_EQUAL(slew.process(DEG(400), ONE_SECOND_MS / 2), DEG(325) + THERMOCOUPLE_SLEW_LIMIT / 2);
+		TEST_EQUAL(slew.process(DEG(200), 0), DEG(325) + THERMOCOUPLE_SLEW_LIMIT / 2);
+
+		slew.reset(DEG(300));
+		TEST_EQUAL(slew.process(DEG(310), ONE_SECOND_MS), DEG(310));
+	}
+
+	// Long gaps are held to a second. 10 minutes at 25 F/s overflows
+	// 32 bits, and a garbage dt would go negative.
+	{
+		CSlewLimiter<THERMOCOUPLE_SLEW_LIMIT> slew;
+		uint32_t gaps[] = { 2 * ONE_SECOND_MS, 600 * ONE_SECOND_MS, 0x7FFFFFFF, 0xFFFFFFFF, (uint32_t)-1 };
+
+		for(unsigned int _ = 0; _ < sizeof(gaps) / sizeof(gaps[0]); ++_)
+		{
+			slew.reset(DEG(300));
+			TEST_EQUAL(slew.process(DEG(400), gaps[_]), DEG(325));
+
+			slew.reset(DEG(300));
+			TEST_EQUAL(slew.process(DEG(200), gaps[_]), DEG(275));
+		}
+	}
+
+	// The whole chain starts exactly on the sample it was reset to
+	{
+		CThermocoupleFilter filter;
+		filter.reset(DEG(412));
+		TEST_EQUAL(filter.process(DEG(412), 0), DEG(412));
+	}
+
+	return testResult("test_sensorfilter");
+}
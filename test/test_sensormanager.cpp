@@ -0,0 +1,88 @@
+////////////////////////////////////////////////////////////
+// CTempSensorManager's read schedule across the millis()
+// rollover, against a simulated MAX6675
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Pins.h"
+#include "Defs.h"
+
+#include "SensorFilter.h"
+#include "TempSensor_Thermocouple.h"
+#include "ThermocoupleBus.h"
+#include "TempSensor_Thermistor.h"
+#include "TempSensorManager.h"
+
+#include "Max6675Sim.h"
+#include "TestCheck.h"
+
+// How long each run is, straddling the rollover
+#define RUN_SECONDS		(20)
+
+// The flue reads once a second however often processFast() is
+// called, with _startBeforeWrap ms to go before millis() wraps
+static void readRate(uint32_t _startBeforeWrap, uint32_t _pollMs)
+{
+	CMax6675Sim chip(PIN_THERMOCOUPLE_CS_FLUE);
+	chip.m_frame = (600 & 0x0FFF) << 3;		// 150 C, 302 F
+
+	g_stubMillis = 0 - _startBeforeWrap;
+	CTempSensorManager manager;
+	manager.init();
+
+	uint32_t frames = 0;
+	uint32_t lastRead = 0;
+	uint32_t shortest = 0xFFFFFFFF;
+	uint32_t longest = 0;
+	uint32_t oldestSample = 0;
+	for(uint32_t _ = 0; _ < (uint32_t)RUN_SECONDS * ONE_SECOND_MS; _ += _pollMs)
+	{
+		g_stubMillis += _pollMs;
+		manager.processFast();
+
+		if(chip.m_frames != frames)
+		{
+			if(frames > 0)
+			{
+				uint32_t interval = chip.m_lastReadTime - lastRead;
+				shortest = min(shortest, interval);
+				longest = max(longest, interval);
+			}
+			frames = chip.m_frames;
+			lastRead = chip.m_lastReadTime;
+		}
+
+		if(frames > 0)
+			oldestSample = max(oldestSample, manager.getSampleAge(TEMP_SENSOR_FLUE));
+	}
+
+	printf("%5lu ms before the wrap, polled every %2lu ms: %2lu reads, %lu to %lu ms apart\n",
+		(unsigned long)_startBeforeWrap, (unsigned long)_pollMs, (unsigned long)frames, (unsigned long)shortest, (unsigned long)longest);
+
+	// The first read waits out the warm up
+	TEST_CHECK(frames >= RUN_SECONDS - 1);
+	TEST_CHECK(frames <= RUN_SECONDS);
+	TEST_CHECK(shortest >= THERMOCOUPLE_READ_PERIOD);
+	TEST_CHECK(longest < THERMOCOUPLE_READ_PERIOD + _pollMs);
+	TEST_CHECK(oldestSample < THERMOCOUPLE_READ_PERIOD + _pollMs);
+	TEST_EQUAL(manager.getSampleSequence(TEMP_SENSOR_FLUE), frames);
+	TEST_EQUAL(manager.temperature(TEMP_SENSOR_FLUE), 302);
+	TEST_EQUAL(chip.m_earlyReads, 0);
+	TEST_EQUAL(chip.m_badFrames, 0);
+}
+
+int main()
+{
+	// Well away from the rollover, then with it landing in the
+	// warm up, on a read, and between reads
+	uint32_t offsets[] = { 0x80000000UL, THERMOCOUPLE_WARMUP_TIME / 2, 10 * ONE_SECOND_MS, 10 * ONE_SECOND_MS + 500, 10 * ONE_SECOND_MS + 501 };
+	uint32_t polls[] = { 1, 7, SCHED_SENSOR_PERIOD };
+
+	for(unsigned int o = 0; o < sizeof(offsets) / sizeof(offsets[0]); ++o)
+	{
+		for(unsigned int p = 0; p < sizeof(polls) / sizeof(polls[0]); ++p)
+			readRate(offsets[o], polls[p]);
+	}
+
+	return testResult("test_sensormanager");
+}
@@ -0,0 +1,118 @@
+////////////////////////////////////////////////////////////
+// CSetpointRamp, on its own and on the simulated burn against
+// the plain setpoint step it replaced
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+
+#include "SetpointRamp.h"
+#include "StoveBurn.h"
+#include "TestCheck.h"
+
+#define DEG(d)	((long)(d) * WSPID_FIXED_ONE)
+
+// The ramp's fraction is truncated, so it can trail by a Q8 count
+#define TEST_NEAR(_a, _b)	TEST_CHECK(labs((_a) - (_b)) <= 1)
+
+static long runFor(CSetpointRamp &_ramp, int _seconds)
+{
+	long setpoint = _ramp.getSetpoint();
+	while(_seconds-- > 0)
+		setpoint = _ramp.processOneSecond();
+	return setpoint;
+}
+
+// _rate 0 is the old setpoint step
+static CBurnStats burn(int _rate, bool _sCurve)
+{
+	CWSPID pid;
+	setupFluePid(pid, 3.27, 0.09, 6.00);
+
+	CSetpointRamp ramp;
+	ramp.jumpTo(DEG(BURN_IDLE_TEMP));
+
+	CBurnSim sim;
+	sim.bumpToMinForcedDraftTemp();
+
+	CBurnStats stats;
+	for(long t = 0; t < BURN_LENGTH; t++)
+	{
+		g_stubMillis = t * ONE_SECOND_MS;
+
+		// The way CTempController::rampSetpoint() starts it
+		if(t == BURN_RUN_START)
+			ramp.start(max(ramp.getSetpoint(), DEG(sim.getTemperature())), DEG(BURN_RUN_TEMP), _rate, _sCurve);
+		if(t == BURN_RUN_END)
+			ramp.jumpTo(DEG(BURN_IDLE_TEMP));
+		pid.SetSetpointFixed(ramp.processOneSecond());
+
+		sim.processOneSecond();
+		int output = blowerCommand(pid.Compute((long)sim.getTemperature() * WSPID_FIXED_ONE, sim.getSampleSequence(), sim.getSampleTime()));
+		sim.setForcedDraftBlower(output);
+		stats.process(t, sim, output);
+	}
+	return stats;
+}
+
+int main()
+{
+	// Linear, 200F at 30F/minute is 400 seconds
+	{
+		CSetpointRamp ramp;
+		ramp.start(DEG(150), DEG(350), 30, false);
+		TEST_CHECK(ramp.isRamping());
+		TEST_NEAR(runFor(ramp, 60), DEG(180));
+		TEST_NEAR(runFor(ramp, 139), DEG(249) + DEG(1) / 2);
+		TEST_EQUAL(runFor(ramp, 201), DEG(350));
+		TEST_CHECK(!ramp.isRamping());
+		TEST_EQUAL(runFor(ramp, 10), DEG(350));
+	}
+
+	// The S-curve takes as long and crosses the middle at the same
+	// time, but starts slower
+	{
+		CSetpointRamp ramp;
+		ramp.start(DEG(150), DEG(350), 30, true);
+		long early = runFor(ramp, 60);
+		TEST_CHECK(early > DEG(150));
+		TEST_CHECK(early < DEG(180));
+		TEST_NEAR(runFor(ramp, 140), DEG(250));
+		TEST_CHECK(runFor(ramp, 190) < DEG(350));
+		TEST_EQUAL(runFor(ramp, 10), DEG(350));
+		TEST_CHECK(!ramp.isRamping());
+	}
+
+	// No rate steps, jumpTo() stops a ramp where it is
+	{
+		CSetpointRamp ramp;
+		ramp.start(DEG(150), DEG(350), 0, false);
+		TEST_CHECK(!ramp.isRamping());
+		TEST_EQUAL(ramp.getSetpoint(), DEG(350));
+
+		ramp.start(DEG(150), DEG(350), 30, false);
+		runFor(ramp, 20);
+		ramp.jumpTo(DEG(200));
+		TEST_EQUAL(runFor(ramp, 5), DEG(200));
+	}
+
+	// On the burn the ramp has to cut the overshoot to within a
+	// couple of degrees, without burning more fuel than the step
+	{
+		CBurnStats step = burn(0, false);
+		CBurnStats linear = burn(SETPOINT_RAMP_RATE, false);
+		CBurnStats sCurve = burn(SETPOINT_RAMP_RATE, true);
+
+		step.print("setpoint step");
+		linear.print("30 F/min ramp");
+		sCurve.print("30 F/min S-curve");
+
+		TEST_CHECK(linear.m_peak < step.m_peak);
+		TEST_CHECK(linear.m_peak <= BURN_RUN_TEMP + 2);
+		TEST_CHECK(sCurve.m_peak <= BURN_RUN_TEMP + 2);
+		TEST_CHECK(linear.m_fuel <= step.m_fuel);
+		TEST_CHECK(sCurve.m_fuel <= step.m_fuel);
+	}
+
+	return testResult("test_setpointramp");
+}
@@ -0,0 +1,123 @@
+////////////////////////////////////////////////////////////
+// The Smith predictor flue controller against plain PID on
+// the simulated burn, and with the model off from the plant
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+
+#include "SetpointRamp.h"
+#include "SmithPredictor.h"
+#include "StoveBurn.h"
+#include "TestCheck.h"
+
+// The PID gains each runs with. The predictor takes the dead time
+// out of the loop, so it can run much hotter gains than plain PID.
+#define PID_KP		(3.27)
+#define PID_KI		(0.09)
+#define PID_KD		(6.00)
+#define SMITH_KP	(10.)
+#define SMITH_KI	(0.5)
+#define SMITH_KD	(0.)
+
+class CSmithBurn : public CBurnStats
+{
+public:
+	// How far off the run setpoint the flue ends the run, the
+	// worst of the last 10 minutes
+	int m_settledError;
+
+	CSmithBurn() { m_settledError = 0; }
+};
+
+// _deadTime 0 runs plain PID. _rate 0 steps the setpoint.
+static CSmithBurn burn(double _modelGain, int _deadTime, int _rate)
+{
+	CWSPID pid;
+	if(_deadTime > 0)
+		setupFluePid(pid, SMITH_KP, SMITH_KI, SMITH_KD);
+	else
+		setupFluePid(pid, PID_KP, PID_KI, PID_KD);
+
+	CSmithPredictor predictor;
+	if(_deadTime > 0)
+		predictor.setModel(_modelGain, FLUE_MODEL_TIME_CONSTANT, _deadTime);
+
+	CSetpointRamp ramp;
+	ramp.jumpTo((long)BURN_IDLE_TEMP * WSPID_FIXED_ONE);
+
+	CBurnSim sim;
+	sim.bumpToMinForcedDraftTemp();
+
+	CSmithBurn stats;
+	int lastOutput = 0;
+	for(long t = 0; t < BURN_LENGTH; t++)
+	{
+		g_stubMillis = t * ONE_SECOND_MS;
+		if(t == BURN_RUN_START)
+			ramp.start(max(ramp.getSetpoint(), (long)sim.getTemperature() * WSPID_FIXED_ONE), (long)BURN_RUN_TEMP * WSPID_FIXED_ONE, _rate, false);
+		if(t == BURN_RUN_END)
+			ramp.jumpTo((long)BURN_IDLE_TEMP * WSPID_FIXED_ONE);
+		pid.SetSetpointFixed(ramp.processOneSecond());
+
+		sim.processOneSecond();
+		long input = (long)sim.getTemperature() * WSPID_FIXED_ONE;
+		if(_deadTime > 0)
+			input += predictor.process(sim.getSampleSequence(), sim.getSampleTime(), lastOutput);
+
+		int output = blowerCommand(pid.Compute(input, sim.getSampleSequence(), sim.getSampleTime()));
+		sim.setForcedDraftBlower(output);
+		stats.process(t, sim, output);
+		lastOutput = output;
+
+		if((t >= BURN_RUN_END - 600) && (t < BURN_RUN_END))
+			stats.m_settledError = max(stats.m_settledError, abs(sim.getTemperature() - BURN_RUN_TEMP));
+	}
+	return stats;
+}
+
+int main()
+{
+	// The model matches CStoveSim. The predictor has to beat PID's
+	// IAE by at least 10% on both the step and the ramp, for no
+	// more overshoot or fuel.
+	{
+		CSmithBurn pidStep = burn(0., 0, 0);
+		CSmithBurn smithStep = burn(FLUE_MODEL_GAIN, FLUE_MODEL_DEAD_TIME, 0);
+		CSmithBurn pidRamp = burn(0., 0, SETPOINT_RAMP_RATE);
+		CSmithBurn smithRamp = burn(FLUE_MODEL_GAIN, FLUE_MODEL_DEAD_TIME, SETPOINT_RAMP_RATE);
+
+		pidStep.print("step, PID");
+		smithStep.print("step, Smith");
+		pidRamp.print("30 F/min ramp, PID");
+		smithRamp.print("30 F/min ramp, Smith");
+
+		TEST_CHECK(smithStep.m_iae < pidStep.m_iae * 0.9);
+		TEST_CHECK(smithRamp.m_iae < pidRamp.m_iae * 0.9);
+		TEST_CHECK(smithStep.m_peak <= pidStep.m_peak);
+		TEST_CHECK(smithRamp.m_peak <= pidRamp.m_peak);
+		TEST_CHECK(smithStep.m_fuel <= pidStep.m_fuel + 0.5);
+		TEST_CHECK(smithRamp.m_fuel <= pidRamp.m_fuel + 0.5);
+	}
+
+	// A wrong model costs overshoot, but the measurement is still in
+	// the loop, so the flue still settles on the setpoint
+	{
+		CSmithBurn lowGain = burn(FLUE_MODEL_GAIN * 0.7, FLUE_MODEL_DEAD_TIME, 0);
+		CSmithBurn highGain = burn(FLUE_MODEL_GAIN * 1.4, FLUE_MODEL_DEAD_TIME, 0);
+		CSmithBurn shortDelay = burn(FLUE_MODEL_GAIN, FLUE_MODEL_DEAD_TIME - 5, 0);
+
+		lowGain.print("step, model gain -30%");
+		highGain.print("step, model gain +40%");
+		shortDelay.print("step, dead time 5 s short");
+
+		TEST_CHECK(lowGain.m_settledError <= 2);
+		TEST_CHECK(highGain.m_settledError <= 2);
+		TEST_CHECK(shortDelay.m_settledError <= 2);
+		TEST_CHECK(lowGain.m_peak <= BURN_RUN_TEMP + 80);
+		TEST_CHECK(highGain.m_peak <= BURN_RUN_TEMP + 80);
+		TEST_CHECK(shortDelay.m_peak <= BURN_RUN_TEMP + 80);
+	}
+
+	return testResult("test_smith");
+}
@@ -0,0 +1,147 @@
+////////////////////////////////////////////////////////////
+// MAX6675 frames clocked out by CThermocoupleBus and decoded
+// by CTempSensor_Thermocouple, against a simulated chip
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Pins.h"
+#include "Defs.h"
+
+#include "SensorFilter.h"
+#include "TempSensor_Thermocouple.h"
+#include "ThermocoupleBus.h"
+
+#include "Max6675Sim.h"
+#include "TestCheck.h"
+
+static CMax6675Sim s_chip(PIN_THERMOCOUPLE_CS_FLUE);
+
+// A frame holding _quarters quarter degrees C
+static unsigned int frameFor(unsigned int _quarters)
+{
+	return (_quarters & 0x0FFF) << 3;
+}
+
+// One fresh sensor per reading, so the filters start over
+static CTempSensor_Thermocouple *readOnce(CThermocoupleBus &_bus, unsigned int _frame)
+{
+	static CTempSensor_Thermocouple *s_sensor = 0;
+
+	delete s_sensor;
+	s_sensor = new CTempSensor_Thermocouple();
+	s_sensor->init(PIN_THERMOCOUPLE_CS_FLUE);
+
+	s_chip.m_frame = _frame;
+	g_stubMillis += ONE_SECOND_MS;
+	s_sensor->updateTemp(_bus);
+	return s_sensor;
+}
+
+int main()
+{
+	CThermocoupleBus bus;
+	bus.init();
+
+	// The bits come out MSB first, all 16 of them, with CS low
+	// only for the frame and SCK left low
+	{
+		unsigned int frames[] = { 0x8001, 0x1234, 0xA5C3, 0x7FFE, 0x0000, 0xFFFF };
+		for(unsigned int _ = 0; _ < sizeof(frames) / sizeof(frames[0]); ++_)
+		{
+			s_chip.m_frame = frames[_];
+			g_stubMillis += THERMOCOUPLE_CONVERSION_TIME;
+			TEST_EQUAL(bus.readFrame(PIN_THERMOCOUPLE_CS_FLUE), frames[_]);
+			TEST_EQUAL(digitalRead(PIN_THERMOCOUPLE_CS_FLUE), HIGH);
+			TEST_EQUAL(digitalRead(PIN_THERMOCOUPLE_SCK), LOW);
+		}
+		TEST_EQUAL(s_chip.m_frames, sizeof(frames) / sizeof(frames[0]));
+		TEST_EQUAL(s_chip.m_badFrames, 0);
+		TEST_EQUAL(s_chip.m_strayEdges, 0);
+		TEST_EQUAL(s_chip.m_earlyReads, 0);
+
+		// The chip notices a read that cuts a conversion short
+		bus.readFrame(PIN_THERMOCOUPLE_CS_FLUE);
+		TEST_EQUAL(s_chip.m_earlyReads, 1);
+		s_chip.m_earlyReads = 0;
+	}
+
+	// Field extraction
+	TEST_EQUAL(THERMOCOUPLE_FRAME_TEMP(frameFor(0)), 0);
+	TEST_EQUAL(THERMOCOUPLE_FRAME_TEMP(frameFor(100)), 100);
+	TEST_EQUAL(THERMOCOUPLE_FRAME_TEMP(frameFor(0x0FFF) | 0x0007), 0x0FFF);
+	TEST_EQUAL(THERMOCOUPLE_FRAME_TEMP(0x8000 | frameFor(4)), 4);
+
+	// Quarter degrees C to degrees F
+	struct { unsigned int m_quarters; int m_degF; long m_fixed; } cases[] =
+	{
+		{ 0,		32,		32L * 256 },				// 0 C
+		{ 100,		77,		77L * 256 },				// 25 C
+		{ 400,		212,	212L * 256 },				// 100 C
+		{ 1,		32,		32L * 256 + 115 },			// 0.25 C = 0.45 F
+		{ 2,		33,		32L * 256 + 230 },			// 0.5 C = 0.9 F
+		{ 0x0FFF,	1875,	(1874L * 256) + 192 },		// 1023.75 C = 1874.75 F
+	};
+	for(unsigned int _ = 0; _ < sizeof(cases) / sizeof(cases[0]); ++_)
+	{
+		CTempSensor_Thermocouple *sensor = readOnce(bus, frameFor(cases[_].m_quarters));
+
+		TEST_CHECK(sensor->getStatus() == CTempSensor_Thermocouple::status_ok);
+		TEST_EQUAL(sensor->temperature(), cases[_].m_degF);
+		TEST_EQUAL(sensor->temperatureFixed(), cases[_].m_fixed);
+	}
+
+	// The open thermocouple bit, with no good reading to hold
+	{
+		CTempSensor_Thermocouple *sensor = readOnce(bus, frameFor(100) | THERMOCOUPLE_FRAME_OPEN);
+
+		TEST_CHECK(sensor->getStatus() == CTempSensor_Thermocouple::status_open);
+		TEST_EQUAL(sensor->temperature(), THERMOCOUPLE_INVALID_TEMP);
+		TEST_EQUAL(sensor->lastFrame(), frameFor(100) | THERMOCOUPLE_FRAME_OPEN);
+	}
+
+	// A probe that comes back after a long time open reads true at
+	// once. The slew limiter must not drag it from the old reading.
+	{
+		CTempSensor_Thermocouple sensor;
+		sensor.init(PIN_THERMOCOUPLE_CS_FLUE);
+
+		s_chip.m_frame = frameFor(600);	// 150 C, 302 F
+		for(int _ = 0; _ < 5; ++_)
+		{
+			g_stubMillis += ONE_SECOND_MS;
+			sensor.updateTemp(bus);
+		}
+		TEST_EQUAL(sensor.temperature(), 302);
+
+		s_chip.m_frame = frameFor(600) | THERMOCOUPLE_FRAME_OPEN;
+		for(int _ = 0; _ < 600; ++_)
+		{
+			g_stubMillis += ONE_SECOND_MS;
+			sensor.updateTemp(bus);
+		}
+		TEST_CHECK(sensor.getStatus() == CTempSensor_Thermocouple::status_open);
+
+		s_chip.m_frame = frameFor(800);	// 200 C, 392 F
+		g_stubMillis += ONE_SECOND_MS;
+		sensor.updateTemp(bus);
+		TEST_CHECK(sensor.getStatus() == CTempSensor_Thermocouple::status_ok);
+		TEST_EQUAL(sensor.temperature(), 392);
+	}
+
+	// Exactly one frame per sample, a second read would restart the
+	// conversion. The sample is stamped with when CS went low.
+	{
+		unsigned long frames = s_chip.m_frames;
+		CTempSensor_Thermocouple *sensor = readOnce(bus, frameFor(100));
+		TEST_EQUAL(s_chip.m_frames - frames, 1);
+		TEST_EQUAL(sensor->getSampleTime(), s_chip.m_lastReadTime);
+	}
+
+	// None of the sensor's reads cut a conversion short or
+	// clocked the bus wrong
+	TEST_EQUAL(s_chip.m_badFrames, 0);
+	TEST_EQUAL(s_chip.m_strayEdges, 0);
+	TEST_EQUAL(s_chip.m_earlyReads, 0);
+
+	return testResult("test_thermocouple");
+}
@@ -0,0 +1,150 @@
+////////////////////////////////////////////////////////////
+// CTimerWheel and CMilliTimer, mostly callbacks that start
+// and reset timers while the wheel is expiring them
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+
+#include "MilliTimer.h"
+#include "TestCheck.h"
+
+CTimerWheel g_timerWheel;
+
+// What the loop passes to advance(), the callbacks read it
+static uint32_t s_now = 0;
+
+// A timer that starts itself again from its own callback
+class CRearmTimer : public CMilliTimer
+{
+public:
+	uint32_t m_period;
+	int m_fires;
+	uint32_t m_lastFire;
+	uint32_t m_shortest;
+	uint32_t m_longest;
+
+	CRearmTimer(uint32_t _period)
+	{
+		m_period = _period;
+		m_fires = 0;
+		m_lastFire = 0;
+		m_shortest = 0xFFFFFFFFUL;
+		m_longest = 0;
+	}
+
+	static void fired(void *_context)
+	{
+		CRearmTimer *timer = (CRearmTimer *)_context;
+		if(timer->m_fires > 0)
+		{
+			uint32_t interval = s_now - timer->m_lastFire;
+			timer->m_shortest = min(timer->m_shortest, interval);
+			timer->m_longest = max(timer->m_longest, interval);
+
+			// Twice on one advance() is the bug, don't go round forever
+			if(interval == 0)
+				return;
+		}
+		timer->m_fires++;
+		timer->m_lastFire = s_now;
+		timer->start(timer->m_period, fired, timer);
+	}
+};
+
+static void runTo(uint32_t _end)
+{
+	while(s_now < _end)
+	{
+		s_now++;
+		g_timerWheel.advance(s_now);
+	}
+}
+
+static void countFire(void *_context)
+{
+	(*(int *)_context)++;
+}
+
+// Resets the first timer and starts the second again
+static CMilliTimer *s_resetTimer;
+static CMilliTimer *s_restartTimer;
+static int s_restartFires;
+
+static void resetOthers(void *)
+{
+	s_resetTimer->reset();
+	s_restartTimer->start(100, countFire, &s_restartFires);
+}
+
+int main()
+{
+	g_timerWheel.start(s_now);
+
+	// A multiple of the wheel's size in ticks puts the timer back in
+	// the slot being expired. It has to wait the wheel round, every time.
+	{
+		CRearmTimer timer(15 * TIMER_WHEEL_TICK_MS);
+		timer.start(timer.m_period, CRearmTimer::fired, &timer);
+		runTo(s_now + 5000);
+
+		TEST_EQUAL(timer.m_shortest, TIMER_WHEEL_SLOTS * TIMER_WHEEL_TICK_MS);
+		TEST_EQUAL(timer.m_longest, TIMER_WHEEL_SLOTS * TIMER_WHEEL_TICK_MS);
+		TEST_CHECK(timer.m_fires >= 5000 / (TIMER_WHEEL_SLOTS * TIMER_WHEEL_TICK_MS));
+		timer.reset();
+	}
+
+	// And with rounds to count down, none may be counted off on the
+	// pass that put it back
+	{
+		CRearmTimer timer(31 * TIMER_WHEEL_TICK_MS);
+		timer.start(timer.m_period, CRearmTimer::fired, &timer);
+		runTo(s_now + 5000);
+
+		TEST_EQUAL(timer.m_shortest, 2 * TIMER_WHEEL_SLOTS * TIMER_WHEEL_TICK_MS);
+		TEST_EQUAL(timer.m_longest, 2 * TIMER_WHEEL_SLOTS * TIMER_WHEEL_TICK_MS);
+		timer.reset();
+	}
+
+	// Never early, whatever part of a tick it is started in
+	for(int offset = 0; offset < TIMER_WHEEL_TICK_MS; offset++)
+	{
+		CMilliTimer timer;
+		runTo(s_now + 1);
+		uint32_t started = s_now;
+		timer.start(100);
+		while(timer.getState() == CMilliTimer::running)
+			runTo(s_now + 1);
+		TEST_CHECK(s_now - started > 100);
+		TEST_CHECK(s_now - started <= 100 + 2 * TIMER_WHEEL_TICK_MS);
+	}
+
+	// A callback that resets one timer and restarts another that
+	// were due on the same tick, but hadn't been run yet
+	{
+		int resetFires = 0;
+		CMilliTimer first;
+		CMilliTimer reset;
+		CMilliTimer restart;
+		s_resetTimer = &reset;
+		s_restartTimer = &restart;
+		s_restartFires = 0;
+
+		// Added to the head of the slot, so this one runs first
+		reset.start(50, countFire, &resetFires);
+		restart.start(50, countFire, &s_restartFires);
+		first.start(50, resetOthers);
+		runTo(s_now + 100);
+
+		TEST_EQUAL(reset.getState(), CMilliTimer::notSet);
+		TEST_EQUAL(resetFires, 0);
+		TEST_EQUAL(restart.getState(), CMilliTimer::running);
+		TEST_EQUAL(s_restartFires, 0);
+
+		runTo(s_now + 200);
+		TEST_EQUAL(s_restartFires, 1);
+		TEST_EQUAL(restart.getState(), CMilliTimer::expired);
+	}
+
+	return testResult("test_timerwheel");
+}
@@ -0,0 +1,302 @@
+////////////////////////////////////////////////////////////
+// CWSPID against PID_v1, the library the sketch ran before it,
+// in closed loop with the stove simulator. Only the plain P/I/D
+// path is compared, the dead zone, D filter and feedforward are
+// off the way PID_v1 had them.
+////////////////////////////////////////////////////////////
+#include <Arduino.h>
+
+#include "Defs.h"
+
+#include "SensorFilter.h"
+#include "TempSensor_Thermocouple.h"
+
+#include "WSPID.h"
+#include "StoveSim.h"
+
+#include "TestCheck.h"
+
+// Every step of the golden trace has to be within this many
+// counts of PID_v1
+#define GOLDEN_TOLERANCE	(1)
+
+////////////////////////////////////////////////////////////
+// Brett Beauregard's PID_v1 1.1.1, Compute(), SetTunings(),
+// SetSampleTime(), SetOutputLimits() and SetMode() as released,
+// DIRECT action only. Wrapped the way the old CWSPID wrapped it,
+// with the input and setpoint scaled instead of the gains.
+////////////////////////////////////////////////////////////
+class CPIDv1
+{
+public:
+	double m_input, m_output, m_setpoint;
+	double m_kp, m_ki, m_kd;
+	double m_ITerm, m_lastInput;
+	double m_outMin, m_outMax;
+	unsigned long m_lastTime;
+	unsigned long m_SampleTime;
+	bool m_inAuto;
+	double m_scale;
+
+	CPIDv1()
+	{
+		m_input = m_output = m_setpoint = 0.;
+		m_ITerm = m_lastInput = 0.;
+		m_inAuto = false;
+		m_scale = 1.;
+
+		SetOutputLimits(0, 255);
+		m_SampleTime = 100;
+		SetTunings(0., 0., 0.);
+		m_lastTime = millis() - m_SampleTime;
+	}
+
+	bool Compute()
+	{
+		if(!m_inAuto)
+			return false;
+		unsigned long now = millis();
+		unsigned long timeChange = (now - m_lastTime);
+		if(timeChange >= m_SampleTime)
+		{
+			double input = m_input;
+			double error = m_setpoint - input;
+			m_ITerm += (m_ki * error);
+			if(m_ITerm > m_outMax)
+				m_ITerm = m_outMax;
+			else if(m_ITerm < m_outMin)
+				m_ITerm = m_outMin;
+			double dInput = (input - m_lastInput);
+
+			double output = m_kp * error + m_ITerm - m_kd * dInput;
+
+			if(output > m_outMax)
+				output = m_outMax;
+			else if(output < m_outMin)
+				output = m_outMin;
+			m_output = output;
+
+			m_lastInput = input;
+			m_lastTime = now;
+			return true;
+		}
+		return false;
+	}
+
+	void SetTunings(double Kp, double Ki, double Kd)
+	{
+		if(Kp < 0 || Ki < 0 || Kd < 0)
+			return;
+
+		double SampleTimeInSec = ((double)m_SampleTime) / 1000;
+		m_kp = Kp;
+		m_ki = Ki * SampleTimeInSec;
+		m_kd = Kd / SampleTimeInSec;
+	}
+
+	void SetSampleTime(int NewSampleTime)
+	{
+		if(NewSampleTime > 0)
+		{
+			double ratio = (double)NewSampleTime / (double)m_SampleTime;
+			m_ki *= ratio;
+			m_kd /= ratio;
+			m_SampleTime = (unsigned long)NewSampleTime;
+		}
+	}
+
+	void SetOutputLimits(double Min, double Max)
+	{
+		if(Min >= Max)
+			return;
+		m_outMin = Min;
+		m_outMax = Max;
+	}
+
+	void SetMode(int Mode)
+	{
+		bool newAuto = (Mode == AUTOMATIC);
+		if(newAuto && !m_inAuto)
+			Initialize();
+		m_inAuto = newAuto;
+	}
+
+	void Initialize()
+	{
+		m_ITerm = m_output;
+		m_lastInput = m_input;
+		if(m_ITerm > m_outMax)
+			m_ITerm = m_outMax;
+		else if(m_ITerm < m_outMin)
+			m_ITerm = m_outMin;
+	}
+
+	// The old CWSPID wrapper around PID_v1
+	void SetSetpoint(int _setpoint) { m_setpoint = _setpoint * m_scale; }
+	int Compute(int _input)
+	{
+		m_input = _input * m_scale;
+		Compute();
+		return (int)floor(m_output + 0.5);
+	}
+};
+
+////////////////////////////////////////////////////////////
+// One 150 -> 350 -> 150 burn under CWSPID, set up the way
+// TempController set up PID_v1, with PID_v1 fed the same
+// readings alongside. Returns the worst difference in counts.
+////////////////////////////////////////////////////////////
+static int goldenTrace(double _kp, double _ki, double _kd)
+{
+	g_stubMillis = 0;
+
+	CWSPID pid;
+	pid.SetSampleTime(ONE_SECOND_MS);
+	pid.SetScale(FLUE_PID_SCALE);
+	pid.SetOutputLimits(PWM_MOTOR_STOP, PWM_MOTOR_MAX_COMMAND);
+	TEST_CHECK(pid.SetTunings(_kp, _ki, _kd));
+	pid.SetSetpoint(150);
+
+	CPIDv1 ref;
+	ref.m_scale = FLUE_PID_SCALE;
+	ref.SetSampleTime(ONE_SECOND_MS);
+	ref.SetOutputLimits(PWM_MOTOR_STOP, PWM_MOTOR_MAX_COMMAND);
+	ref.SetTunings(_kp, _ki, _kd);
+	ref.SetSetpoint(150);
+
+	CStoveSim sim;
+	sim.bumpToMinForcedDraftTemp();
+
+	int steps = 0, worst = 0, mismatches = 0;
+	int output = PWM_MOTOR_STOP;
+	for(int32_t t = 0; t < 4L * 3600; t++)
+	{
+		g_stubMillis = t * ONE_SECOND_MS;
+
+		// A few seconds in MANUAL with the blower off first, so
+		// both pick up from there
+		if(t == 10)
+		{
+			pid.SetMode(AUTOMATIC);
+			ref.SetMode(AUTOMATIC);
+		}
+		if(t == 1800)
+		{
+			pid.SetSetpoint(350);
+			ref.SetSetpoint(350);
+		}
+		if(t == 3L * 3600)
+		{
+			pid.SetSetpoint(150);
+			ref.SetSetpoint(150);
+		}
+
+		sim.processOneSecond();
+		int temp = sim.getTemperature();
+		output = pid.Compute((int32_t)temp * WSPID_FIXED_ONE, sim.getSampleSequence(), sim.getSampleTime());
+
+		int diff = abs(output - ref.Compute(temp));
+		steps++;
+		worst = max(worst, diff);
+		if(diff > GOLDEN_TOLERANCE)
+			mismatches++;
+
+		sim.setForcedDraftBlower(output);
+	}
+
+	printf("Kp %5.2f Ki %4.2f Kd %5.2f: %d steps, worst %d counts\n", _kp, _ki, _kd, steps, worst);
+	TEST_EQUAL(mismatches, 0);
+	return worst;
+}
+
+int main()
+{
+	// Gentle gains, and ones hot enough to swing the blower
+	// across its whole range
+	goldenTrace(3.27, 0.09, 6.);
+	goldenTrace(10., 0.5, 20.);
+	goldenTrace(40., 0.05, 0.);
+
+	// Errors far past anything real clamp instead of wrapping
+	{
+		CWSPID pid;
+		pid.SetSampleTime(THERMOCOUPLE_CONVERSION_TIME);
+		pid.SetOutputLimits(FIREBOX_SETPOINT_MIN, FIREBOX_SETPOINT_MAX);
+		pid.SetTunings(15., 5., 10.);
+		pid.SetMode(AUTOMATIC);
+
+		pid.SetSetpoint(2000);
+		TEST_EQUAL(pid.Compute(-2000L * WSPID_FIXED_ONE, 1, THERMOCOUPLE_CONVERSION_TIME), FIREBOX_SETPOINT_MAX);
+		pid.SetSetpoint(-2000);
+		TEST_EQUAL(pid.Compute(2000L * WSPID_FIXED_ONE, 2, 2 * THERMOCOUPLE_CONVERSION_TIME), FIREBOX_SETPOINT_MIN);
+	}
+
+	// Changing the gains in AUTOMATIC doesn't bump the output
+	{
+		CWSPID pid;
+		pid.SetSampleTime(ONE_SECOND_MS);
+		pid.SetOutputLimits(PWM_MOTOR_STOP, PWM_MOTOR_MAX_COMMAND);
+		pid.SetTunings(2., 0.1, 0.);
+		pid.SetOutput(100);
+		pid.SetMode(AUTOMATIC);
+		pid.SetSetpoint(300);
+		pid.Compute(290L * WSPID_FIXED_ONE, 1, 1000);
+
+		int before = pid.Compute(290L * WSPID_FIXED_ONE, 2, 2000);
+		pid.SetTunings(5., 0.1, 0.);
+		TEST_CHECK(abs(pid.Compute(290L * WSPID_FIXED_ONE, 3, 3000) - before) <= 1);
+	}
+
+	// The output filter is a first order lag on the output, and
+	// going to AUTOMATIC starts it where manual left off
+	{
+		CWSPID pid;
+		pid.SetSampleTime(ONE_SECOND_MS);
+		pid.SetOutputLimits(PWM_MOTOR_STOP, PWM_MOTOR_MAX_COMMAND);
+		pid.SetOutputFilter(3L * ONE_SECOND_MS);
+		pid.SetTunings(10., 0., 0.);
+		pid.SetOutput(50);
+		pid.SetSetpoint(100);
+		pid.Compute(100L * WSPID_FIXED_ONE, 1, 1000);
+		pid.SetMode(AUTOMATIC);
+		TEST_EQUAL(pid.Compute(100L * WSPID_FIXED_ONE, 2, 2000), 50);
+
+		// P steps to 150, the output gets a quarter of the rest of
+		// the way there each sample
+		int output = 0;
+		for(int sample = 0; sample < 3; sample++)
+			output = pid.Compute(90L * WSPID_FIXED_ONE, 3 + sample, 3000 + sample * 1000);
+		TEST_EQUAL(output, (int)floor(150 - 100 * pow(0.75, 3) + 0.5));
+	}
+
+	// Gains past what the mantissa holds are clamped and reported,
+	// and the gains read back are the ones in use
+	{
+		CWSPID pid;
+		pid.SetSampleTime(THERMOCOUPLE_CONVERSION_TIME);
+		pid.SetScale(FLUE_PID_SCALE);
+		TEST_CHECK(pid.SetTunings(100., 1., 10.));
+		TEST_CHECK(!pid.GetTuningsClamped());
+		TEST_EQUAL(pid.GetKp(), 100.);
+
+		// Kp 200 is 20 counts per degree after the scale, Kd 10
+		// is 4 a sample at 250 ms
+		TEST_CHECK(!pid.SetTunings(200., 1., 50.));
+		TEST_CHECK(pid.GetTuningsClamped());
+		TEST_CHECK(fabs(pid.GetKp() * FLUE_PID_SCALE - WSPID_GAIN_MAX) < 0.001);
+		TEST_CHECK(fabs(pid.GetKd() * FLUE_PID_SCALE * ONE_SECOND_MS / THERMOCOUPLE_CONVERSION_TIME - WSPID_GAIN_MAX) < 0.001);
+		TEST_EQUAL(pid.GetKi(), 1.);
+
+		// Setting the clamped gains again is clean
+		TEST_CHECK(pid.SetTunings(pid.GetKp(), pid.GetKi(), pid.GetKd()));
+
+		// A clamped gain still drives the output the most it can
+		pid.SetOutputLimits(-30000, 30000);
+		pid.SetTunings(200., 0., 0.);
+		pid.SetMode(AUTOMATIC);
+		pid.SetSetpoint(100);
+		TEST_EQUAL(pid.Compute(0, 1, THERMOCOUPLE_CONVERSION_TIME), (int)floor(100 * WSPID_GAIN_MAX + 0.5));
+	}
+
+	return testResult("test_wspid");
+}